@@ -10,7 +10,11 @@ AudioInput::AudioInput()
     : m_streamDevice(paNoDevice),
       m_stream(nullptr),
       m_isRecording(false),
-      m_bufferQueue(30) {}
+      m_ring(1 << 18),
+      m_overrunCount(0),
+      m_droppedSampleCount(0) {
+    m_retrieved.reserve(m_ring.capacity());
+}
 
 void AudioInput::setDevice(AudioDeviceInfo device) {
     bool restart = m_isRecording;
@@ -68,14 +72,14 @@ void AudioInput::stopRecording() {
 bool AudioInput::isRecording() const { return m_isRecording; }
 
 void AudioInput::retrieveBuffers() {
-    do {
-        const auto buffer = m_bufferQueue.peek();
-        if (buffer == nullptr) {
-            break;
-        }
-        m_bufferCallback(*buffer);
-        m_bufferQueue.pop();
-    } while (true);
+    const size_t available = m_ring.readAvailable();
+    if (available == 0) {
+        return;
+    }
+
+    m_retrieved.resize(available);
+    m_ring.read(m_retrieved.data(), available);
+    m_bufferCallback(m_retrieved);
 }
 
 bool AudioInput::setupStream() {
@@ -129,6 +133,18 @@ double AudioInput::sampleRate() const {
     return m_device.availableSampleRates.back();
 }
 
+bool AudioInput::waitForBuffers(const int timeoutMs) {
+    return m_buffersReady.wait(static_cast<std::int64_t>(timeoutMs) * 1000);
+}
+
+uint64_t AudioInput::overrunCount() const {
+    return m_overrunCount.load(std::memory_order_relaxed);
+}
+
+uint64_t AudioInput::droppedSampleCount() const {
+    return m_droppedSampleCount.load(std::memory_order_relaxed);
+}
+
 int AudioInput::streamCallback(const void *voidInput, void *output,
                                unsigned long frameCount,
                                const PaStreamCallbackTimeInfo *timeInfo,
@@ -137,13 +153,16 @@ int AudioInput::streamCallback(const void *voidInput, void *output,
     const auto input = static_cast<const float *>(voidInput);
     auto self = static_cast<AudioInput *>(userData);
 
-    std::vector<float> buffer(frameCount);
-    std::copy(input, input + frameCount, buffer.begin());
+    const size_t written = self->m_ring.write(input, frameCount);
 
-    if (!self->m_bufferQueue.try_enqueue(std::move(buffer))) {
-        // Queue overflow
-        std::cout << "buffer queue overflow" << std::endl;
+    if (written < frameCount) {
+        self->m_overrunCount.fetch_add(1, std::memory_order_relaxed);
+        self->m_droppedSampleCount.fetch_add(frameCount - written,
+                                             std::memory_order_relaxed);
     }
 
+    // Only touches the OS semaphore when the consumer is actually asleep.
+    if (written > 0) self->m_buffersReady.signal();
+
     return paContinue;
 }
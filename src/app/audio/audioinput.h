@@ -1,20 +1,19 @@
 #ifndef REFORMANT_AUDIO_AUDIOINPUT_H
 #define REFORMANT_AUDIO_AUDIOINPUT_H
 
-#include <readerwriterqueue/readerwriterqueue.h>
+#include <readerwriterqueue/atomicops.h>
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
-#include <mutex>
-#include <queue>
 #include <vector>
 
 #include "audiodevices.h"
 #include "portaudio.h"
+#include "ringbuffer.h"
 
 namespace reformant {
 
-using namespace moodycamel;
-
 class AudioInput {
    public:
     using BufferCallback = std::function<void(const std::vector<float> &)>;
@@ -31,10 +30,20 @@ class AudioInput {
 
     void closeStream();
 
+    // Hands everything captured since the last call to the buffer callback,
+    // as one contiguous buffer.
     void retrieveBuffers();
 
+    // Blocks until the stream callback delivers new samples or the timeout
+    // expires. Returns false on timeout. Wakeups may be spurious.
+    bool waitForBuffers(int timeoutMs);
+
     double sampleRate() const;
 
+    // Number of callbacks that found the ring full, and samples dropped.
+    uint64_t overrunCount() const;
+    uint64_t droppedSampleCount() const;
+
    private:
     bool setupStream();
 
@@ -52,7 +61,14 @@ class AudioInput {
     bool m_isRecording;
 
     BufferCallback m_bufferCallback;
-    BlockingReaderWriterQueue<std::vector<float>> m_bufferQueue;
+
+    // Filled by the stream callback, drained by retrieveBuffers().
+    RingBuffer m_ring;
+    std::vector<float> m_retrieved;
+    moodycamel::spsc_sema::LightweightSemaphore m_buffersReady;
+
+    std::atomic<uint64_t> m_overrunCount;
+    std::atomic<uint64_t> m_droppedSampleCount;
 };
 
 };  // namespace reformant
@@ -23,6 +23,10 @@ void AudioOutput::setBufferCallback(BufferCallback callback) {
     m_bufferCallback = callback;
 }
 
+void AudioOutput::setStartCallback(StartCallback callback) {
+    m_startCallback = callback;
+}
+
 void AudioOutput::startPlaying() {
     bool isSetup = false;
 
@@ -40,6 +44,8 @@ void AudioOutput::startPlaying() {
         return;
     }
 
+    if (m_startCallback) m_startCallback();
+
     PaError err = Pa_StartStream(m_stream);
     if (err != paNoError) {
         std::cerr << "Failed to start audio stream: " << Pa_GetErrorText(err)
@@ -123,9 +129,7 @@ int AudioOutput::streamCallback(const void *input, void *voidOutput,
     const auto output = static_cast<float *>(voidOutput);
     auto self = static_cast<AudioOutput *>(userData);
 
-    std::vector<float> buffer(frameCount);
-    bool doContinue = self->m_bufferCallback(buffer);
-    std::copy(buffer.begin(), buffer.end(), output);
+    const bool doContinue = self->m_bufferCallback(output, frameCount);
 
     return doContinue ? paContinue : paComplete;
 }
@@ -1,28 +1,26 @@
 #ifndef REFORMANT_AUDIO_AUDIOOUTPUT_H
 #define REFORMANT_AUDIO_AUDIOOUTPUT_H
 
-#include <readerwriterqueue/readerwriterqueue.h>
-
 #include <functional>
-#include <mutex>
-#include <queue>
-#include <vector>
 
 #include "audiodevices.h"
 #include "portaudio.h"
 
 namespace reformant {
 
-using namespace moodycamel;
-
 class AudioOutput {
    public:
-    using BufferCallback = std::function<bool(std::vector<float> &)>;
+    // Called from the audio thread: must fill the buffer without blocking or
+    // allocating. Returning false ends the stream.
+    using BufferCallback = std::function<bool(float *, unsigned long)>;
+    // Called before the stream is (re)started.
+    using StartCallback = std::function<void()>;
 
     AudioOutput();
 
     void setDevice(AudioDeviceInfo device);
     void setBufferCallback(BufferCallback callback);
+    void setStartCallback(StartCallback callback);
 
     void startPlaying();
     void stopPlaying();
@@ -50,6 +48,7 @@ class AudioOutput {
     bool m_isPlaying;
 
     BufferCallback m_bufferCallback;
+    StartCallback m_startCallback;
 };
 
 };  // namespace reformant
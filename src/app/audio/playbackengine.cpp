@@ -0,0 +1,169 @@
+#include "playbackengine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "../state.h"
+
+using namespace std::chrono;
+using namespace reformant;
+
+// About a third of a second at 48kHz.
+static constexpr size_t ringCapacity = 1 << 14;
+
+// Don't bother waking up the resampler for less than this many frames.
+static constexpr size_t minPrefetchFrames = 1024;
+static constexpr size_t maxPrefetchFrames = 4096;
+
+PlaybackEngine::PlaybackEngine(AppState& appState, const int approxPrefetchDelayMs)
+    : appState(appState),
+      m_approxPrefetchDelayMs(approxPrefetchDelayMs),
+      m_isRunning(false),
+      m_ring(ringCapacity),
+      m_resampledWritten(0),
+      m_tailQueued(false),
+      m_readPosition(0),
+      m_reachedEnd(true),
+      m_startSample(0),
+      m_trackToDeviceRatio(1),
+      m_framesPlayed(0),
+      m_isFinished(true),
+      m_underrunCount(0) {
+    m_chunk.reserve(maxPrefetchFrames);
+    m_resampled.reserve(maxPrefetchFrames);
+}
+
+void PlaybackEngine::start() {
+    m_isRunning = true;
+    m_thread = std::thread([this] { run(); });
+}
+
+void PlaybackEngine::terminate() {
+    m_isRunning = false;
+    m_thread.join();
+}
+
+void PlaybackEngine::seek(const int64_t trackSample) {
+    std::lock_guard lockGuard(m_mutex);
+
+    const double fsIn = appState.audioTrack.sampleRate();
+    const double fsOut = appState.audioOutput.sampleRate();
+
+    m_resampler.setRate(fsIn, fsOut);
+    m_resampler.reset();
+    m_resampler.skipZeros();
+
+    m_ring.reset();
+    m_resampled.clear();
+    m_resampledWritten = 0;
+    m_tailQueued = false;
+
+    m_readPosition = std::max(trackSample, appState.audioTrack.firstSample());
+    m_reachedEnd.store(false, std::memory_order_release);
+
+    m_startSample = m_readPosition;
+    m_trackToDeviceRatio = fsIn / fsOut;
+
+    m_framesPlayed.store(0, std::memory_order_relaxed);
+    m_isFinished.store(false, std::memory_order_relaxed);
+}
+
+bool PlaybackEngine::render(float* out, const unsigned long frameCount) {
+    const size_t n = m_ring.read(out, frameCount);
+    std::fill(out + n, out + frameCount, 0.0f);
+
+    const int64_t framesPlayed = m_framesPlayed.fetch_add(n, std::memory_order_relaxed);
+
+    if (n < frameCount) {
+        // The end flag is only raised after the last samples were queued.
+        if (m_reachedEnd.load(std::memory_order_acquire) && m_ring.readAvailable() == 0) {
+            m_isFinished.store(true, std::memory_order_relaxed);
+            return false;
+        }
+        // Not counted while the first prefetch is still on its way.
+        if (framesPlayed > 0) {
+            m_underrunCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    return true;
+}
+
+int64_t PlaybackEngine::position() const {
+    const int64_t framesPlayed = m_framesPlayed.load(std::memory_order_relaxed);
+    return m_startSample + std::llround(framesPlayed * m_trackToDeviceRatio);
+}
+
+bool PlaybackEngine::isFinished() const {
+    return m_isFinished.load(std::memory_order_relaxed);
+}
+
+uint64_t PlaybackEngine::underrunCount() const {
+    return m_underrunCount.load(std::memory_order_relaxed);
+}
+
+void PlaybackEngine::run() {
+    while (m_isRunning) {
+        prefetch();
+        std::this_thread::sleep_for(milliseconds(m_approxPrefetchDelayMs));
+    }
+}
+
+void PlaybackEngine::prefetch() {
+    if (m_reachedEnd.load(std::memory_order_acquire)) return;
+
+    // Same lock order as seek(), which is called with the track locked.
+    const auto trackLease = appState.audioTrack.lease();
+    std::lock_guard lockGuard(m_mutex);
+
+    if (m_reachedEnd.load(std::memory_order_relaxed) || !m_resampler.isValid()) {
+        return;
+    }
+    const int64_t trackSamples = appState.audioTrack.sampleCount();
+
+    // Playing slower than the rolling window moves: skip what was trimmed.
+    m_readPosition = std::max(m_readPosition, appState.audioTrack.firstSample());
+
+    // The resampler may produce more than asked for, and the tail more than
+    // there is room for. Whatever doesn't fit waits for the next pass.
+    while (writeResampled()) {
+        if (m_tailQueued) {
+            m_reachedEnd.store(true, std::memory_order_release);
+            break;
+        }
+
+        if (m_ring.writeAvailable() < minPrefetchFrames) break;
+
+        if (m_readPosition >= trackSamples) {
+            // Push the resampler's tail out so the last samples are heard.
+            m_chunk.assign(m_resampler.inputLatency(), 0.0f);
+            m_resampler.process(m_resampled, m_chunk.data(),
+                                static_cast<int>(m_chunk.size()));
+            m_resampledWritten = 0;
+            m_tailQueued = true;
+            continue;
+        }
+
+        const int outLength =
+            static_cast<int>(std::min(m_ring.writeAvailable(), maxPrefetchFrames));
+        const int inLength = static_cast<int>(
+            std::min<int64_t>(m_resampler.requiredInputFrames(outLength),
+                              trackSamples - m_readPosition));
+
+        const auto view = appState.audioTrack.view(m_readPosition, inLength);
+        m_chunk.resize(view.size());
+        view.copyTo(m_chunk.data());
+
+        m_resampler.process(m_resampled, m_chunk.data(), static_cast<int>(m_chunk.size()));
+        m_resampledWritten = 0;
+
+        m_readPosition += inLength;
+    }
+}
+
+bool PlaybackEngine::writeResampled() {
+    m_resampledWritten += m_ring.write(m_resampled.data() + m_resampledWritten,
+                                       m_resampled.size() - m_resampledWritten);
+    return m_resampledWritten == m_resampled.size();
+}
@@ -0,0 +1,89 @@
+#ifndef REFORMANT_AUDIO_PLAYBACKENGINE_H
+#define REFORMANT_AUDIO_PLAYBACKENGINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../processing/resampler.h"
+#include "ringbuffer.h"
+
+namespace reformant {
+
+struct AppState;
+
+// Feeds the output device from the track.
+// A helper thread reads ahead from the track, resamples to the device rate and
+// queues the result in a lock-free ring. The device callback only copies out
+// of the ring and publishes how far it got, so it never waits on the track
+// lock or the resampler.
+class PlaybackEngine final {
+   public:
+    explicit PlaybackEngine(AppState& appState, int approxPrefetchDelayMs = 5);
+
+    void start();
+    void terminate();
+
+    // Restart playback from a track sample. The output stream must be stopped.
+    void seek(int64_t trackSample);
+
+    // Device callback side. Fills the whole buffer, padding with silence if
+    // the ring runs dry, and returns false once the end of the track has
+    // been played.
+    bool render(float* out, unsigned long frameCount);
+
+    // Track sample currently being played.
+    [[nodiscard]] int64_t position() const;
+
+    [[nodiscard]] bool isFinished() const;
+
+    // Device buffers the ring couldn't fill while playing, since startup.
+    [[nodiscard]] uint64_t underrunCount() const;
+
+   private:
+    void run();
+
+    void prefetch();
+
+    // Queue what is left of m_resampled. True if all of it fit in the ring.
+    bool writeResampled();
+
+    AppState& appState;
+
+    int m_approxPrefetchDelayMs;
+
+    std::thread m_thread;
+    std::atomic<bool> m_isRunning;
+
+    // Held by the prefetch thread while it fills the ring, and by seek().
+    std::mutex m_mutex;
+
+    RingBuffer m_ring;
+    Resampler m_resampler;
+    std::vector<float> m_chunk;
+    std::vector<float> m_resampled;
+    // Frames of m_resampled already in the ring. The rest goes in first on
+    // the next pass.
+    size_t m_resampledWritten;
+    // The resampler's tail is in m_resampled, the end is reached once it has
+    // all been queued.
+    bool m_tailQueued;
+
+    // Next track sample to prefetch.
+    int64_t m_readPosition;
+    std::atomic<bool> m_reachedEnd;
+
+    // Only written in seek(), while the stream is stopped.
+    int64_t m_startSample;
+    double m_trackToDeviceRatio;
+
+    std::atomic<int64_t> m_framesPlayed;
+    std::atomic<bool> m_isFinished;
+    std::atomic<uint64_t> m_underrunCount;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_AUDIO_PLAYBACKENGINE_H
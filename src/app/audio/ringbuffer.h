@@ -0,0 +1,96 @@
+#ifndef REFORMANT_AUDIO_RINGBUFFER_H
+#define REFORMANT_AUDIO_RINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace reformant {
+
+// Lock-free single-producer single-consumer ring of samples.
+// Neither side ever allocates or blocks, so the producer can be an audio
+// callback. The capacity is rounded up to a power of two.
+class RingBuffer final {
+   public:
+    explicit RingBuffer(size_t capacity)
+        : m_capacity(roundUpPow2(capacity)),
+          m_mask(m_capacity - 1),
+          m_buffer(std::make_unique<float[]>(m_capacity)),
+          m_writePos(0),
+          m_readPos(0) {}
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+    // Producer side. Writes as many samples as fit and returns that count.
+    size_t write(const float* data, const size_t count) {
+        const size_t writePos = m_writePos.load(std::memory_order_relaxed);
+        const size_t readPos = m_readPos.load(std::memory_order_acquire);
+
+        const size_t n = std::min(count, m_capacity - (writePos - readPos));
+        const size_t start = writePos & m_mask;
+        const size_t first = std::min(n, m_capacity - start);
+
+        std::copy_n(data, first, m_buffer.get() + start);
+        std::copy_n(data + first, n - first, m_buffer.get());
+
+        m_writePos.store(writePos + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side. Reads up to count samples and returns how many were read.
+    size_t read(float* data, const size_t count) {
+        const size_t readPos = m_readPos.load(std::memory_order_relaxed);
+        const size_t writePos = m_writePos.load(std::memory_order_acquire);
+
+        const size_t n = std::min(count, writePos - readPos);
+        const size_t start = readPos & m_mask;
+        const size_t first = std::min(n, m_capacity - start);
+
+        std::copy_n(m_buffer.get() + start, first, data);
+        std::copy_n(m_buffer.get(), n - first, data + first);
+
+        m_readPos.store(readPos + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side.
+    [[nodiscard]] size_t readAvailable() const {
+        return m_writePos.load(std::memory_order_acquire) -
+               m_readPos.load(std::memory_order_relaxed);
+    }
+
+    // Producer side.
+    [[nodiscard]] size_t writeAvailable() const {
+        return m_capacity - (m_writePos.load(std::memory_order_relaxed) -
+                             m_readPos.load(std::memory_order_acquire));
+    }
+
+    // Empties the ring. Neither side may be running concurrently.
+    void reset() {
+        m_writePos.store(0, std::memory_order_relaxed);
+        m_readPos.store(0, std::memory_order_relaxed);
+    }
+
+   private:
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<float[]> m_buffer;
+
+    // Monotonic positions, on separate cache lines to avoid false sharing.
+    alignas(64) std::atomic<size_t> m_writePos;
+    alignas(64) std::atomic<size_t> m_readPos;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_AUDIO_RINGBUFFER_H
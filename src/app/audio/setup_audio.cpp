@@ -3,6 +3,7 @@
 #include <iostream>
 
 #include "../processing/controller/spectrogramcontroller.h"
+#include "playbackengine.h"
 #include "../state.h"
 
 void reformant::setupAudio(AppState& appState) {
@@ -71,39 +72,18 @@ void reformant::setupAudio(AppState& appState) {
 
     appState.audioTrack.setSampleRate(appState.settings.trackSampleRate());
     appState.audioTrack.setDenoising(appState.settings.doNoiseReduction());
+    appState.audioTrack.setStorage(appState.settings.diskBackedTrack()
+                                       ? SampleStorage_MappedFile
+                                       : SampleStorage_Memory);
+    appState.audioTrack.setRollingWindow(60.0 * appState.settings.rollingWindowMinutes());
 
-    // Create resampler for track-to-output-device conversion.
-    appState.audioOutputResampler.setRate(appState.audioTrack.sampleRate(),
-                                          appState.audioOutput.sampleRate());
+    // Playback restarts from the cursor, at the current track and device rates.
+    appState.audioOutput.setStartCallback([&] {
+        appState.playbackEngine->seek(appState.spectrogramController->timeSamples());
+    });
 
     appState.audioOutput.setBufferCallback(
-        [&](std::vector<float>& buffer) -> bool {
-            const int bufferLength = buffer.size();
-            const int trackSamples = appState.audioTrack.sampleCount();
-            const int offset = appState.spectrogramController->timeSamples();
-            const double fsIn = appState.audioTrack.sampleRate();
-            const double fsOut = appState.audioOutput.sampleRate();
-
-            appState.audioOutputResampler.setRate(fsIn, fsOut);
-
-            if (offset < trackSamples) {
-                const int inBufferLength =
-                    appState.audioOutputResampler.requiredInputFrames(
-                        bufferLength);
-
-                const int copyLength =
-                    std::min(inBufferLength, trackSamples - offset);
-                const auto chunk = appState.audioTrack.data(offset, copyLength);
-
-                appState.audioOutputResampler.process(buffer, chunk);
-                buffer.resize(bufferLength, 0);
-
-                appState.spectrogramController->setTimeSamples(offset +
-                                                               inBufferLength);
-                return true;
-            } else {
-                // Played past the end: stop playing.
-                return false;
-            }
+        [&](float* buffer, const unsigned long frameCount) -> bool {
+            return appState.playbackEngine->render(buffer, frameCount);
         });
 }
\ No newline at end of file
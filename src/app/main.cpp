@@ -7,9 +7,11 @@
 #include <implot.h>
 #include <portaudio.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 
+#include "audio/playbackengine.h"
 #include "audio/setup_audio.h"
 #include "processing/controller/pitchcontroller.h"
 #include "processing/controller/formantcontroller.h"
@@ -18,6 +20,7 @@
 #include "processing/thread/consumerthread.h"
 #include "processing/thread/processingthread.h"
 #include "processing/thread/visualisationthread.h"
+#include "processing/thread/workerpool.h"
 #include "state.h"
 #include "ui/ui.h"
 #include "memusage.h"
@@ -43,12 +46,29 @@ int main(int argc, char* argv[]) {
 
     reformant::ui::setupImGui(appState);
 
+    // The audio callbacks play through the engine, it must exist before them.
+    reformant::PlaybackEngine playbackEngine(appState);
+    appState.playbackEngine = &playbackEngine;
+
     reformant::setupAudio(appState);
 
+    reformant::WorkerPool workerPool;
+    appState.workerPool = &workerPool;
+
     reformant::PitchController pitchController(appState);
+    pitchController.setEstimatorType(
+        static_cast<reformant::PitchEstimatorType>(appState.settings.pitchEstimator()));
+    pitchController.setNccfMethod(
+        static_cast<reformant::NccfMethod>(appState.settings.pitchNccfMethod()));
+    pitchController.setHopMs(appState.settings.pitchHopMs());
+    pitchController.setTrackingLagMs(appState.settings.pitchTrackingLagMs());
     appState.pitchController = &pitchController;
 
     reformant::FormantController formantController(appState);
+    // The setting comes from a file that may be from another version.
+    const int rootSolver = std::clamp<int>(appState.settings.formantRootSolver(),
+                                           ROOTS_BAIRSTOW, ROOTS_ABERTH);
+    formantController.setRootSolver(static_cast<RootSolver>(rootSolver));
     appState.formantController = &formantController;
 
     reformant::SpectrogramController spectrogramController(appState);
@@ -62,6 +82,7 @@ int main(int argc, char* argv[]) {
 
     appState.ui.showAudioSettings = appState.settings.showAudioSettings();
     appState.ui.showDisplaySettings = appState.settings.showDisplaySettings();
+    appState.ui.showAnalysisSettings = appState.settings.showAnalysisSettings();
     appState.ui.showProfiler = appState.settings.showProfiler();
 
     appState.settings.spectrumPlotRatios(appState.ui.spectrumPlotRatios);
@@ -87,11 +108,16 @@ int main(int argc, char* argv[]) {
 
     appState.ui.isRecording = false;
     appState.ui.isInTimeScrollAnimation = false;
+    appState.ui.isScrubbing = false;
+    appState.ui.resumeAfterScrub = false;
 
     appState.ui.averageProcessingTime = -1;
 
     ImGuiIO& io = ImGui::GetIO();
 
+    // Start the playback prefetch thread.
+    playbackEngine.start();
+
     // Start the audio consumer thread.
     reformant::ConsumerThread consumerThread(appState);
     consumerThread.start();
@@ -161,6 +187,9 @@ int main(int argc, char* argv[]) {
     processingThread.terminate();
     visualisationThread.terminate();
 
+    appState.audioOutput.closeStream();
+    playbackEngine.terminate();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImPlot::DestroyContext();
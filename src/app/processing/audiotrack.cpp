@@ -1,33 +1,73 @@
 #include "audiotrack.h"
 
-#include <cmath>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
 using namespace reformant;
 
-AudioTrack::AudioTrack() : m_sampleRate(0) {
+namespace {
+
+// Copy of the samples of a store, in another storage.
+SampleStore movedTo(const SampleStore& store, const SampleStorage storage) {
+    SampleStore moved(storage);
+    moved.clear(store.begin());
+    for (int64_t offset = store.begin(); offset < store.size();) {
+        const auto span = store.contiguous(offset, store.size() - offset);
+        moved.append(span.data(), static_cast<int64_t>(span.size()));
+        offset += static_cast<int64_t>(span.size());
+    }
+    return moved;
+}
+
+}  // namespace
+
+AudioTrack::AudioTrack()
+    : m_sampleRate(0),
+      m_inputRate(0),
+      m_rollingWindow(0),
+      m_summary(std::make_unique<WaveformSummary>()),
+      m_generation(0),
+      m_needsResampleTo48kHz(false),
+      m_needsResampleToTrack(false),
+      m_doDenoising(false) {
 }
 
+AudioTrack::~AudioTrack() { cancelPendingResample(); }
+
 void AudioTrack::append(const std::vector<float>& chunk, const double fsIn) {
-    const double fsOut = m_sampleRate;
+    if (fsIn != m_inputRate) {
+        m_inputRate = fsIn;
+        rebuildIngestChain();
+    }
 
-    m_resamplerTo48kHz.setRate(fsIn, 48000);
-    m_resamplerToTrack.setRate(48000, fsOut);
+    const std::vector<float>* stage = &chunk;
 
-    auto chunk48kHz = m_resamplerTo48kHz.process(chunk);
+    if (m_needsResampleTo48kHz) {
+        m_resamplerTo48kHz.process(m_chunk48kHz, *stage);
+        stage = &m_chunk48kHz;
+    }
 
-    // If denoising is enabled, process it now.
-    // (The denoiser only takes 48kHz audio)
     if (m_doDenoising) {
-        chunk48kHz = m_denoiser.process(chunk48kHz);
+        m_denoiser.process(m_chunkDenoised, stage->data(),
+                           static_cast<int>(stage->size()));
+        stage = &m_chunkDenoised;
     }
 
-    const auto trackChunk = m_resamplerToTrack.process(chunk48kHz);
+    if (m_needsResampleToTrack) {
+        m_resamplerToTrack.process(m_chunkTrack, *stage);
+        stage = &m_chunkTrack;
+    }
 
-    m_track.insert(m_track.end(), trackChunk.begin(), trackChunk.end());
+    m_track.append(*stage);
+    m_summary->append(stage->data(), static_cast<int64_t>(stage->size()));
 }
 
-void AudioTrack::reset() { m_track.clear(); }
+void AudioTrack::reset() {
+    ++m_generation;
+    m_track.clear();
+    m_summary->clear();
+}
 
 void AudioTrack::setSampleRate(double sampleRate) {
     const double oldSR = m_sampleRate;
@@ -36,41 +76,293 @@ void AudioTrack::setSampleRate(double sampleRate) {
     if (oldSR > 0 && sampleRate != oldSR) {
         resampleTrack(oldSR, sampleRate);
     }
+
+    rebuildIngestChain();
 }
 
-void AudioTrack::setDenoising(bool denoising) { m_doDenoising = denoising; }
+void AudioTrack::requestSampleRate(const double sampleRate) {
+    if (m_pending) {
+        if (sampleRate == m_pending->fsOut) return;
+        cancelPendingResample();
+    }
+
+    if (sampleRate == m_sampleRate) return;
+
+    if (m_track.empty() || m_sampleRate <= 0) {
+        setSampleRate(sampleRate);
+        return;
+    }
+
+    m_pending = std::make_unique<PendingResample>();
+    auto& pending = *m_pending;
+    pending.fsOut = sampleRate;
+    pending.generation = m_generation;
+    pending.storage = m_track.storage();
+    pending.resampler.setRate(m_sampleRate, sampleRate);
+    pending.resampler.reset();
+    pending.consumed = m_track.begin();
+
+    // A trimmed track keeps its start time.
+    const int64_t begin = std::llround(pending.consumed * sampleRate / m_sampleRate);
+    pending.resampled = SampleStore(m_track.storage());
+    pending.resampled.clear(begin);
+    pending.summary = std::make_unique<WaveformSummary>();
+    pending.summary->clear(begin);
+    pending.isReady = false;
+    pending.isCancelled = false;
+
+    // Same alignment as resampleTrack().
+    const std::vector<float> latency(pending.resampler.outputLatency(), 0);
+    pending.resampled.append(latency);
+    pending.summary->append(latency.data(), static_cast<int64_t>(latency.size()));
+
+    pending.thread = std::thread([this] { runPendingResample(); });
+}
+
+bool AudioTrack::isChangingSampleRate() const { return m_pending != nullptr; }
+
+double AudioTrack::pendingSampleRate() const {
+    return (m_pending != nullptr) ? m_pending->fsOut : 0;
+}
+
+bool AudioTrack::isSampleRateChangeReady() const {
+    return m_pending != nullptr && m_pending->isReady;
+}
+
+bool AudioTrack::finishSampleRateChange() {
+    if (!isSampleRateChangeReady()) return false;
+
+    m_pending->thread.join();
+    auto pending = std::move(m_pending);
+
+    if (pending->generation != m_generation) {
+        // The track was replaced while resampling, what's left of it is new.
+        setSampleRate(pending->fsOut);
+        return true;
+    }
+
+    // Only the samples appended since the pass caught up are left.
+    feedPendingResample(pending.get(), m_track.size());
+    applyPendingStorage(pending.get());
+
+    ++m_generation;
+    m_track = std::move(pending->resampled);
+    m_summary = std::move(pending->summary);
+    m_sampleRate = pending->fsOut;
+
+    rebuildIngestChain();
+    return true;
+}
+
+void AudioTrack::setDenoising(bool denoising) {
+    if (denoising != m_doDenoising) {
+        m_doDenoising = denoising;
+        // Don't let stale samples from a previous run leak into the track.
+        if (denoising) m_denoiser.reset();
+        rebuildIngestChain();
+    }
+}
+
+void AudioTrack::setRollingWindow(const double seconds) {
+    m_rollingWindow = std::max(seconds, 0.0);
+}
+
+double AudioTrack::rollingWindow() const { return m_rollingWindow; }
+
+bool AudioTrack::needsTrim() const {
+    if (m_rollingWindow <= 0 || m_sampleRate <= 0 || m_pending) return false;
+
+    const auto window = static_cast<int64_t>(m_rollingWindow * m_sampleRate);
+    return m_track.size() - m_track.begin() > window + SampleStore::segmentLength;
+}
+
+void AudioTrack::trimToRollingWindow() {
+    if (!needsTrim()) return;
+
+    const auto window = static_cast<int64_t>(m_rollingWindow * m_sampleRate);
+    m_track.dropBefore(m_track.size() - window);
+    m_summary->dropBefore(m_track.begin());
+}
+
+void AudioTrack::setStorage(const SampleStorage storage) {
+    // The pass moves its own store over before it is swapped in, and reads
+    // the same samples from the new one in the meantime.
+    if (m_pending) m_pending->storage = storage;
+
+    if (storage == m_track.storage()) return;
+
+    m_track = movedTo(m_track, storage);
+}
 
 double AudioTrack::sampleRate() const { return m_sampleRate; }
 
 double AudioTrack::duration() const { return m_track.size() / m_sampleRate; }
 
-int AudioTrack::sampleCount() const { return m_track.size(); }
+int64_t AudioTrack::firstSample() const { return m_track.begin(); }
+
+int64_t AudioTrack::sampleCount() const { return m_track.size(); }
 
 bool AudioTrack::isDenoising() const { return m_doDenoising; }
 
-std::vector<float> AudioTrack::data(const int offset, int length) {
-    if (offset < 0 || offset >= m_track.size()) {
+SampleStorage AudioTrack::storage() const { return m_track.storage(); }
+
+uint64_t AudioTrack::bytesAllocated() const { return m_track.bytesAllocated(); }
+
+std::vector<float> AudioTrack::data(int64_t offset, int64_t length) {
+    const int64_t trackSize = sampleCount();
+
+    // The oldest audio may have been trimmed already.
+    if (offset < firstSample()) {
+        if (length >= 0) length = std::max<int64_t>(length + offset - firstSample(), 0);
+        offset = firstSample();
+    }
+
+    if (offset >= trackSize) {
         return {};
     }
 
-    if (length < 0) {
-        length = m_track.size() - offset;
+    if (length < 0 || offset + length > trackSize) {
+        length = trackSize - offset;
     }
 
     std::vector<float> copy(length);
-    std::copy_n(m_track.begin() + offset, length, copy.begin());
+    m_track.copy(offset, length, copy.data());
 
     return copy;
 }
 
-std::timed_mutex& AudioTrack::mutex() { return m_mutex; }
+SampleView AudioTrack::view(const int64_t offset, int64_t length) const {
+    const int64_t trackSize = sampleCount();
 
-void AudioTrack::resampleTrack(const double fsIn, const double fsOut) {
-    m_resamplerToTrack.setRate(48000, fsOut);
+    if (offset < firstSample() || offset >= trackSize) {
+        return {};
+    }
 
+    if (length < 0 || offset + length > trackSize) {
+        length = trackSize - offset;
+    }
+
+    return {&m_track, offset, length};
+}
+
+WaveformStats AudioTrack::waveformStats(const int64_t offset,
+                                        const int64_t length) const {
+    return m_summary->stats(m_track, offset, length);
+}
+
+AudioTrack::Lease AudioTrack::lease() { return Lease(m_mutex); }
+
+std::shared_mutex& AudioTrack::mutex() { return m_mutex; }
+
+void AudioTrack::resampleTrack(const double fsIn, const double fsOut) {
     if (!m_track.empty()) {
+        // Resample one segment at a time into a new store, so that we never
+        // hold more than one extra segment worth of temporary buffers.
         Resampler resampler(fsIn, fsOut);
-        m_track = resampler.process(m_track);
-        m_track.insert(m_track.begin(), m_resamplerToTrack.outputLatency(), 0);
+
+        // A trimmed track keeps its start time.
+        SampleStore resampled(m_track.storage());
+        resampled.clear(std::llround(m_track.begin() * fsOut / fsIn));
+        resampled.append(std::vector<float>(resampler.outputLatency(), 0));
+        std::vector<float> in(SampleStore::segmentLength);
+        std::vector<float> out;
+
+        for (int64_t offset = m_track.begin(); offset < m_track.size();
+             offset += SampleStore::segmentLength) {
+            const int64_t length =
+                std::min(SampleStore::segmentLength, m_track.size() - offset);
+            m_track.copy(offset, length, in.data());
+            resampler.process(out, in.data(), static_cast<int>(length));
+            resampled.append(out);
+        }
+
+        ++m_generation;
+        m_track = std::move(resampled);
+        m_summary->rebuild(m_track);
+    }
+}
+
+void AudioTrack::runPendingResample() {
+    PendingResample* pending = m_pending.get();
+
+    while (!pending->isCancelled) {
+        // One segment at a time, under a lease that is short enough not to
+        // hold up structural changes for long. Don't block on the lease: the
+        // owner of the exclusive lock may be waiting for this thread to stop.
+        const Lease lease(m_mutex, std::try_to_lock);
+        if (!lease.owns_lock()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        if (pending->generation != m_generation) break;
+
+        const int64_t size = m_track.size();
+        if (pending->consumed >= size) break;
+
+        const int64_t end =
+            std::min(size, pending->consumed + SampleStore::segmentLength);
+        feedPendingResample(pending, end);
     }
-}
\ No newline at end of file
+
+    applyPendingStorage(pending);
+    pending->isReady = true;
+}
+
+void AudioTrack::feedPendingResample(PendingResample* pending, const int64_t end) {
+    while (pending->consumed < end) {
+        const int64_t length =
+            std::min(SampleStore::segmentLength, end - pending->consumed);
+        pending->in.resize(length);
+        m_track.copy(pending->consumed, length, pending->in.data());
+        pending->resampler.process(pending->out, pending->in.data(),
+                                   static_cast<int>(length));
+        pending->resampled.append(pending->out);
+        pending->summary->append(pending->out.data(),
+                                 static_cast<int64_t>(pending->out.size()));
+        pending->consumed += length;
+    }
+}
+
+void AudioTrack::applyPendingStorage(PendingResample* pending) {
+    const SampleStorage storage = pending->storage;
+    if (storage == pending->resampled.storage()) return;
+
+    pending->resampled = movedTo(pending->resampled, storage);
+}
+
+void AudioTrack::cancelPendingResample() {
+    if (!m_pending) return;
+
+    // The pass never blocks on the track mutex, so this is safe to call with
+    // the mutex held.
+    m_pending->isCancelled = true;
+    m_pending->thread.join();
+    m_pending.reset();
+}
+
+void AudioTrack::rebuildIngestChain() {
+    const double fsIn = m_inputRate;
+    const double fsOut = m_sampleRate;
+
+    // Nothing to build until both ends are known.
+    if (fsIn <= 0 || fsOut <= 0) {
+        m_needsResampleTo48kHz = false;
+        m_needsResampleToTrack = false;
+        return;
+    }
+
+    const double fsMid = m_doDenoising ? 48000 : fsIn;
+
+    m_needsResampleTo48kHz = (fsMid != fsIn);
+    if (m_needsResampleTo48kHz) {
+        m_resamplerTo48kHz.setRate(fsIn, fsMid);
+        m_resamplerTo48kHz.reset();
+    }
+
+    m_needsResampleToTrack = (fsOut != fsMid);
+    if (m_needsResampleToTrack) {
+        m_resamplerToTrack.setRate(fsMid, fsOut);
+        m_resamplerToTrack.reset();
+    }
+}
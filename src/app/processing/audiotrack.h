@@ -1,47 +1,177 @@
 #ifndef REFORMANT_PROCESSING_AUDIOTRACK_H
 #define REFORMANT_PROCESSING_AUDIOTRACK_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <vector>
 
 #include "denoiser.h"
 #include "resampler.h"
+#include "samplestore.h"
+#include "waveformsummary.h"
 
 namespace reformant {
+// Readers hold a shared lease on the track while they access samples. The
+// committed sample count is published atomically, so a lease never waits on
+// append(): it only waits for structural changes (reset, sample rate or
+// denoising changes, trimming), which must be done while holding mutex()
+// exclusively.
+//
+// With a rolling window, only the most recent audio is kept. Sample indices
+// and times stay absolute: the track covers [firstSample(), sampleCount()).
 class AudioTrack {
 public:
+    using Lease = std::shared_lock<std::shared_mutex>;
+
     AudioTrack();
 
+    ~AudioTrack();
+
+    // Only one thread may append at a time, either under a shared lease or
+    // with the track mutex held exclusively.
     void append(const std::vector<float>& chunk, double sampleRate);
 
     void reset();
 
+    // Resamples the whole track right away. Needs the track mutex exclusively.
     void setSampleRate(double sampleRate);
 
+    // Resample the track on a background thread, reading it under short
+    // leases so that appends and readers carry on at the current rate. The
+    // rate only changes in finishSampleRateChange(), which needs the track
+    // mutex exclusively but only has the tail appended in the meantime left to
+    // resample. An empty track changes rate right away. Needs the track mutex
+    // exclusively.
+    void requestSampleRate(double sampleRate);
+
+    [[nodiscard]] bool isChangingSampleRate() const;
+
+    // Rate the track is being resampled to, zero if none.
+    [[nodiscard]] double pendingSampleRate() const;
+
+    // The background pass has caught up, finishSampleRateChange() is cheap.
+    [[nodiscard]] bool isSampleRateChangeReady() const;
+
+    // Swap in the resampled track if it is ready. Returns true if the sample
+    // rate changed.
+    bool finishSampleRateChange();
+
     void setDenoising(bool denoising);
 
+    // Keep only about the last seconds of audio, zero keeps everything.
+    void setRollingWindow(double seconds);
+
+    [[nodiscard]] double rollingWindow() const;
+
+    // Enough audio fell out of the rolling window to drop a segment. Needs a
+    // lease, trimming is skipped while the sample rate is changing.
+    [[nodiscard]] bool needsTrim() const;
+
+    // Drop the audio that fell out of the rolling window, a whole segment at
+    // a time. Needs the track mutex exclusively.
+    void trimToRollingWindow();
+
+    // Moves the existing samples over to the new storage. A pending sample
+    // rate change carries on and ends up in the new storage too.
+    void setStorage(SampleStorage storage);
+
     [[nodiscard]] double sampleRate() const;
 
+    // Time at the end of the track.
     [[nodiscard]] double duration() const;
 
-    [[nodiscard]] int sampleCount() const;
+    // Index of the oldest sample still in the track.
+    [[nodiscard]] int64_t firstSample() const;
+
+    // Index one past the newest sample.
+    [[nodiscard]] int64_t sampleCount() const;
 
     [[nodiscard]] bool isDenoising() const;
 
-    std::vector<float> data(int offset = 0, int length = -1);
+    [[nodiscard]] SampleStorage storage() const;
 
-    std::timed_mutex& mutex();
+    // Memory taken by the samples, see SampleStore::bytesAllocated().
+    [[nodiscard]] uint64_t bytesAllocated() const;
+
+    // Copy from offset, or from the oldest sample if that is later.
+    std::vector<float> data(int64_t offset = 0, int64_t length = -1);
+
+    // Zero-copy read access. The view must not outlive the lease it was taken
+    // under. Empty if offset is outside of the track.
+    [[nodiscard]] SampleView view(int64_t offset = 0, int64_t length = -1) const;
+
+    // Min/max/RMS over a range, answered from the summary pyramid.
+    [[nodiscard]] WaveformStats waveformStats(int64_t offset, int64_t length) const;
+
+    [[nodiscard]] Lease lease();
+
+    std::shared_mutex& mutex();
 
 private:
+    // Background pass of requestSampleRate().
+    struct PendingResample {
+        double fsOut;
+        uint64_t generation;
+        // Where the resampled track ends up, setStorage() may change it while
+        // the pass runs.
+        std::atomic<SampleStorage> storage;
+        Resampler resampler;
+        SampleStore resampled;
+        std::unique_ptr<WaveformSummary> summary;
+        // Track samples consumed so far.
+        int64_t consumed;
+        std::vector<float> in;
+        std::vector<float> out;
+        std::atomic_bool isReady;
+        std::atomic_bool isCancelled;
+        std::thread thread;
+    };
+
     void resampleTrack(double fsIn, double fsOut);
 
+    void runPendingResample();
+
+    // Feed track samples [pending->consumed, end) to the pending resample.
+    void feedPendingResample(PendingResample* pending, int64_t end);
+
+    void cancelPendingResample();
+
+    // Move the pending store over to the storage asked for last, if needed.
+    void applyPendingStorage(PendingResample* pending);
+
+    // Set up the shortest resampling chain from the input rate to the track
+    // rate for the current configuration. The denoiser only takes 48kHz audio,
+    // so it needs a detour through 48kHz; without it, resample in one go.
+    void rebuildIngestChain();
+
     double m_sampleRate;
+    double m_inputRate;
+    double m_rollingWindow;
+
+    std::shared_mutex m_mutex;
+    SampleStore m_track;
+    std::unique_ptr<WaveformSummary> m_summary;
 
-    std::timed_mutex m_mutex;
-    std::vector<float> m_track;
+    // Bumped by every structural change to m_track, so that a background
+    // resample can tell the samples it started from are gone. Moving them to
+    // another storage keeps them as they are.
+    std::atomic<uint64_t> m_generation;
+    std::unique_ptr<PendingResample> m_pending;
 
+    // Input -> 48kHz, only used when denoising.
     Resampler m_resamplerTo48kHz;
+    // 48kHz -> track when denoising, input -> track otherwise.
     Resampler m_resamplerToTrack;
+    bool m_needsResampleTo48kHz;
+    bool m_needsResampleToTrack;
+
+    std::vector<float> m_chunk48kHz;
+    std::vector<float> m_chunkDenoised;
+    std::vector<float> m_chunkTrack;
 
     bool m_doDenoising;
     Denoiser m_denoiser;
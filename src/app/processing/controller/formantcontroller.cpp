@@ -1,144 +1,368 @@
 #include "formantcontroller.h"
 
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
 
 #include "../../state.h"
 #include "../routines/routines.h"
+#include "../thread/workerpool.h"
 
 using namespace reformant;
 
 namespace {
-void subtractReferenceMean(std::vector<float>& s);
-std::vector<float> downsampleSignal(const std::vector<float>& s, int off, int len,
-                                    double Fs, double Fds, Resampler& resampler);
+constexpr int formantCount = 3;
+
+// Rate of the decimated copy that LPC runs on.
+constexpr double Fds = 11000.0;
+
+// lpc_poles always uses 25 ms windows with LPC_BSA.
+constexpr double windowDuration = 25.0 / 1000.0;     // Window size of each LPC frame
+constexpr double frameIntervalTime = 10.0 / 1000.0;  // Time between each LPC frame
+
+// How far the tracker looks ahead before committing to a frame.
+constexpr double trackingLag = 250.0 / 1000.0;
+
+// Most audio analysed in one update per worker, keeps the lock short when
+// catching up.
+constexpr double maxUpdateDuration = 2.0;
+
+// Frames per LPC chunk, each one a parallel task. Backlogs shorter than two of
+// these are analysed on the calling thread.
+constexpr int lpcChunkFrames = 32;
+
+// Longest range redone in one update after a sample rate change.
+constexpr double staleChunkLength = 2.0;
+
+FormantFrame toFrame(const FormantDecision& decision) {
+    FormantFrame frame{};
+    for (int i = 0; i < formantCount; ++i) {
+        frame.freq[i] = static_cast<float>(decision.freq[i]);
+        frame.band[i] = static_cast<float>(decision.band[i]);
+    }
+    return frame;
+}
 }  // namespace
 
 FormantController::FormantController(AppState& appState)
     : appState(appState),
       m_dsResampler(4),
-      m_lastTime(0),
+      m_dsOrigin(0),
+      m_dsFedUntil(0),
+      m_lpcStart(0),
+      m_rootSolver(ROOTS_BAIRSTOW),
+      m_averageFrameMicros(-1),
       m_lastSampleRate(-1),
-      m_tracking(3, -10) {}
+      m_lastTrackSamples(0),
+      m_tracking(formantCount, -10),
+      m_formantSummaries(formantCount),
+      m_committedSize(0),
+      m_staleRanges(staleChunkLength),
+      m_staleResampler(4),
+      m_staleTracking(formantCount, -10) {
+    m_tracking.reset(static_cast<int>(std::round(trackingLag / frameIntervalTime)),
+                     1.0 / frameIntervalTime);
+}
 
 void FormantController::forceClear(bool lock) {
     if (lock) m_mutex.lock();
 
-    m_times.clear();
-    m_frequencies.clear();
+    m_formants.clear();
+    for (auto& summary : m_formantSummaries) summary.clear();
+    m_committedSize = 0;
+    m_staleRanges.clear();
 
-    m_dsResampler.reset();
-    m_dsResampler.skipZeros();
+    // Restarted from the beginning on the next update.
+    m_tracking.clear();
+    m_lastSampleRate = -1;
+    m_lastTrackSamples = 0;
 
     if (lock) m_mutex.unlock();
 }
 
 void FormantController::updateIfNeeded() {
-    using namespace std::chrono_literals;
-
-    // Just return if we couldn't lock, this isn't important because it's
-    // ran periodically, and it avoids a potential deadlock.
-    const std::unique_lock trackLock(appState.audioTrack.mutex(), 50ms);
-    if (!trackLock.owns_lock()) return;
+    // Appends don't block the lease, only structural changes to the track do.
+    const auto trackLease = appState.audioTrack.lease();
 
     std::lock_guard lockGuard(m_mutex);
 
+    m_decisions.clear();
+
     // Track sample rate.
     const double Fs = appState.audioTrack.sampleRate();
 
     if (Fs != m_lastSampleRate) {
-        m_lastTime = std::round((m_lastTime / m_lastSampleRate) * Fs);
+        // Frames analysed at the old rate stay on display and are redone
+        // progressively, carry on from the next one.
+        int64_t origin = 0;
+        if (m_lastSampleRate > 0) {
+            const double nextTime = m_dsOrigin / m_lastSampleRate + m_lpcStart / Fds;
+            origin = std::llround(nextTime * Fs);
+            m_staleRanges.mark(0, origin / Fs);
+        }
         m_lastSampleRate = Fs;
+        restartAnalysis(origin, Fs);
     }
 
     // Track length in samples.
-    const int trackSamples = appState.audioTrack.sampleCount();
+    const int64_t trackSamples = appState.audioTrack.sampleCount();
 
-    if (!m_times.empty() && trackSamples < m_lastTime) {
+    if (trackSamples < m_dsFedUntil) {
         return;
     }
 
-    constexpr double windowDuration = 15.0 / 1000.0;     // Window size of each LPC frame
-    constexpr double frameIntervalTime = 10.0 / 1000.0;  // Time between each LPC frame
-    const int frameInterval = static_cast<int>(std::round(frameIntervalTime * Fs));
+    // Rolling track: forget what fell out of it, and carry on from its start
+    // if we fell behind.
+    const int64_t firstSample = appState.audioTrack.firstSample();
+    if (firstSample > 0) {
+        const double firstTime = firstSample / Fs;
+        m_formants.dropBefore(firstTime);
+        for (auto& summary : m_formantSummaries) summary.dropBefore(firstTime);
+        m_staleRanges.dropBefore(firstTime);
+        if (m_dsFedUntil < firstSample) {
+            restartAnalysis(firstSample, Fs);
+        }
+    }
 
-    constexpr double analysisDuration = 500.0 / 1000.0;  // Approx time of each analysis
-    constexpr double analysisGap = 100.0 / 1000.0;  // Approx gap between each analysis
+    WorkerPool& pool = *appState.workerPool;
+    extendDownsampledSignal(trackSamples,
+                            std::llround(maxUpdateDuration * pool.workerCount() * Fs));
+
+    // Analyse the frames that are complete, each of them once. Ask for one
+    // spare frame so that rounding in lpc_poles never leaves it with none.
+    const int frameLength = static_cast<int>(std::round(windowDuration * Fds));
+    const int frameInterval = static_cast<int>(std::round(frameIntervalTime * Fds));
+
+    int frameCount = 0;
+    if (m_lpcSignal.size() >= frameLength + 2 * frameInterval) {
+        const int backlog = (static_cast<int>(m_lpcSignal.size()) - frameLength) /
+                            frameInterval;
+
+        m_lpcContexts.resize(pool.workerCount());
+        const RootSolver rootSolver = m_rootSolver.load(std::memory_order_relaxed);
+        m_lpcContext.rootSolver = rootSolver;
+        for (auto& context : m_lpcContexts) context.rootSolver = rootSolver;
+
+        // Chunks are counted from the analysis origin, so both paths give the
+        // same poles however far behind the analysis is.
+        const int64_t firstFrame = m_lpcStart / frameInterval;
+        const bool isParallel = backlog >= 2 * lpcChunkFrames && pool.workerCount() > 1;
+        const auto analysisStart = std::chrono::steady_clock::now();
+        const auto ps =
+            isParallel
+                ? lpc_poles(pool, m_lpcContexts, m_lpcContext, m_lpcSignal, Fds,
+                            windowDuration, frameIntervalTime, 12, 0.97, LPC_BSA,
+                            WINDOW_HAMMING, firstFrame, lpcChunkFrames)
+                : lpc_poles(m_lpcContext, m_lpcSignal, Fds, windowDuration,
+                            frameIntervalTime, 12, 0.97, LPC_BSA, WINDOW_HAMMING,
+                            firstFrame, lpcChunkFrames);
+        frameCount = ps.length;
+
+        // Frames of a parallel backlog overlap in time, so only frames
+        // analysed one after the other give their cost.
+        if (frameCount > 0 && !isParallel) {
+            const std::chrono::duration<double, std::micro> elapsed =
+                std::chrono::steady_clock::now() - analysisStart;
+            const double frameMicros = elapsed.count() / frameCount;
+            const double average = m_averageFrameMicros.load(std::memory_order_relaxed);
+            m_averageFrameMicros.store(
+                (average >= 0) ? 0.9 * average + 0.1 * frameMicros : frameMicros,
+                std::memory_order_relaxed);
+        }
 
-    // Exact sample counts.
-    const int analysisSamplesEx = static_cast<int>(std::round(analysisDuration * Fs));
-    const int analysisGapSamplesEx = static_cast<int>(std::round(analysisGap * Fs));
+        for (int j = 0; j < frameCount; ++j) {
+            const auto& pole = ps.pole[j];
+            const double time = m_dsOrigin / Fs + (m_lpcStart + pole.offset) / Fds;
 
-    // Sample counts rounded to an integer multiple of frameInterval
-    const int analysisSamples = (analysisSamplesEx / frameInterval) * frameInterval;
-    const int analysisGapSamples = (analysisGapSamplesEx / frameInterval) * frameInterval;
+            FormantDecision decision;
+            if (m_tracking.push(time, pole, decision)) {
+                m_decisions.push_back(decision);
+            }
+        }
 
-    // Find largest negative track offset.
-    int trackOffset = 0;
-    while (trackOffset < analysisGapSamples && m_lastTime - trackOffset >= 0) {
-        trackOffset += frameInterval;
+        const int64_t consumed = static_cast<int64_t>(frameCount) * frameInterval;
+        m_lpcSignal.erase(m_lpcSignal.begin(), m_lpcSignal.begin() + consumed);
+        m_lpcStart += consumed;
     }
-    if (trackOffset > 0) trackOffset -= frameInterval;
-
-    const int trackIndex = m_lastTime - trackOffset;
 
-    // Find largest analysis length.
-    int analysisLength = 0;
-    while (analysisLength < analysisSamples &&
-           trackIndex + analysisLength <= trackSamples) {
-        analysisLength += frameInterval;
+    // Without new audio there is nothing left to wait for.
+    const bool idle = frameCount == 0 && trackSamples == m_lastTrackSamples;
+    if (idle) {
+        m_tracking.flush(m_decisions);
     }
-    analysisLength -= frameInterval;
+    m_lastTrackSamples = trackSamples;
 
-    if (analysisLength < frameInterval) {
-        m_lastTime = (trackSamples / frameInterval) * frameInterval;
-        return;
+    if (frameCount > 0 || !m_decisions.empty()) {
+        publish();
     }
 
-    m_lastTime += analysisGapSamples;
-
-    const auto os = appState.audioTrack.data(trackIndex, analysisLength);
+    recomputeStaleChunk(Fs, firstSample, trackSamples);
+}
 
-    constexpr double Fds = 11000.0;
-    const double trackIndexDs = (trackIndex / Fs) * Fds;
+void FormantController::restartAnalysis(const int64_t origin, const double Fs) {
+    // The frames still in the tracker won't get any more context, commit them.
+    m_tracking.flush(m_decisions);
 
     m_dsResampler.setRate(Fs, Fds);
     m_dsResampler.reset();
     m_dsResampler.skipZeros();
-    const auto ds = m_dsResampler.process(os);
-
-    std::vector<double> s(ds.begin(), ds.end());
-    for (auto& x : s) x *= std::numeric_limits<int16_t>::max();
 
-    const auto ps = lpc_poles(s, Fds, windowDuration, frameIntervalTime, 12, 0.97,
-                              LPC_BSA, WINDOW_HAMMING);
+    m_dsOrigin = origin;
+    m_dsFedUntil = origin;
+    m_lpcSignal.clear();
+    m_lpcStart = 0;
+}
 
-    const auto track = m_tracking.track(ps);
-    // track.form : (nForm, ps.length)
+void FormantController::extendDownsampledSignal(const int64_t trackSamples,
+                                                const int64_t maxSamples) {
+    const int64_t end = std::min(trackSamples, m_dsFedUntil + maxSamples);
+    if (m_dsFedUntil >= end) return;
 
-    if (track.form.cols() < 1) return;
+    const auto view = appState.audioTrack.view(m_dsFedUntil, end - m_dsFedUntil);
+    view.forEachSpan([&](const std::span<const float> span) {
+        m_dsResampler.process(m_dsChunk, span.data(), static_cast<int>(span.size()));
+        for (const float x : m_dsChunk) {
+            m_lpcSignal.push_back(x * std::numeric_limits<int16_t>::max());
+        }
+    });
 
-    // Replace time range with new tracked range.
-    const double firstTime = trackIndex / Fs;
+    m_dsFedUntil = end;
+}
 
-    auto it = m_times.begin();
-    auto it2 = m_frequencies.begin();
-    while (it != m_times.end()) {
-        if (*it >= firstTime) {
-            it = m_times.erase(it);
-            it2 = m_frequencies.erase(it2);
-        } else {
-            ++it;
-            ++it2;
+void FormantController::recomputeStaleChunk(const double Fs, const int64_t firstSample,
+                                            const int64_t trackSamples) {
+    double timeMin, timeMax;
+    if (!m_staleRanges.take(timeMin, timeMax)) return;
+
+    const int frameLength = static_cast<int>(std::round(windowDuration * Fds));
+    const int frameInterval = static_cast<int>(std::round(frameIntervalTime * Fds));
+    const int lagFrames = m_tracking.lagFrames();
+
+    // Frames on the same grid and in the same LPC chunks as an analysis of
+    // the whole track, from up to lagFrames before the range to as many after
+    // it. The analysis starts from the chunk boundary before the first one.
+    const auto frameAt = [](const double time) -> int64_t {
+        return std::llround(std::ceil(time / frameIntervalTime));
+    };
+    const int64_t trackFrame = frameAt(firstSample / Fs);
+    const int64_t firstFrame = std::max(frameAt(timeMin) - lagFrames, trackFrame);
+    const int64_t chunkStart =
+        std::max(firstFrame - firstFrame % lpcChunkFrames, trackFrame);
+    const int64_t endFrame = frameAt(timeMax) + lagFrames;
+
+    const int64_t begin = std::llround(chunkStart * frameIntervalTime * Fs);
+    m_staleResampler.setRate(Fs, Fds);
+    m_staleResampler.reset();
+    m_staleResampler.skipZeros();
+
+    // A bit past the last frame, for the filter delay.
+    const int64_t end = std::min<int64_t>(
+        trackSamples,
+        std::llround((endFrame * frameIntervalTime + windowDuration) * Fs) +
+            2 * m_staleResampler.inputLatency());
+    if (end <= begin) return;
+
+    m_staleSignal.clear();
+    appState.audioTrack.view(begin, end - begin)
+        .forEachSpan([&](const std::span<const float> span) {
+            m_staleResampler.process(m_dsChunk, span.data(),
+                                     static_cast<int>(span.size()));
+            for (const float x : m_dsChunk) {
+                m_staleSignal.push_back(x * std::numeric_limits<int16_t>::max());
+            }
+        });
+
+    if (m_staleSignal.size() < frameLength + 2 * frameInterval) return;
+
+    // Chunks cut by the start of a rolling track start afresh here.
+    m_staleContext.rootSolver = m_rootSolver.load(std::memory_order_relaxed);
+    m_staleContext.rng.seed(
+        static_cast<uint32_t>(LpcContext::defaultSeed + chunkStart / lpcChunkFrames));
+    m_staleContext.restartRoots = true;
+    const auto ps = lpc_poles(m_staleContext, m_staleSignal, Fds, windowDuration,
+                              frameIntervalTime, 12, 0.97, LPC_BSA, WINDOW_HAMMING,
+                              chunkStart, lpcChunkFrames);
+
+    // Frames before firstFrame only line the chunk up, the tracker starts
+    // after them.
+    m_staleTracking.reset(lagFrames, 1.0 / frameIntervalTime);
+    m_decisions.clear();
+    for (int j = static_cast<int>(firstFrame - chunkStart); j < ps.length; ++j) {
+        const auto& pole = ps.pole[j];
+        const double time = begin / Fs + pole.offset / Fds;
+
+        FormantDecision decision;
+        if (m_staleTracking.push(time, pole, decision)) {
+            m_decisions.push_back(decision);
         }
     }
-
-    for (int i = 0; i < track.form.rows(); ++i) {
-        for (int j = 0; j < track.form.cols(); ++j) {
-            const double time = (trackIndexDs + track.form(i, j).offset) / Fds;
-            m_times.push_back(time);
-            m_frequencies.push_back(track.form(i, j).freq);
+    m_staleTracking.flush(m_decisions);
+
+    // The context frames only steer the path, their results stay as they are.
+    m_staleTimes.clear();
+    m_staleFrames.clear();
+    for (const auto& decision : m_decisions) {
+        if (decision.time >= timeMin && decision.time < timeMax) {
+            m_staleTimes.push_back(decision.time);
+            m_staleFrames.push_back(toFrame(decision));
         }
     }
+    m_decisions.clear();
+
+    // Stale ranges end where the analysis at the current rate starts, so they
+    // only ever hold committed frames.
+    const int64_t sizeChange =
+        m_formants.replaceRange(timeMin, timeMax, m_staleTimes, m_staleFrames);
+    m_committedSize += sizeChange;
+
+    for (int i = 0; i < formantCount; ++i) {
+        m_formantSummaries[i].updateRange(m_formants, timeMin, timeMax, sizeChange,
+                                          [i](const FormantFrame& frame) -> double {
+                                              return frame.freq[i];
+                                          });
+    }
+}
+
+void FormantController::publish() {
+    m_provisional.clear();
+    m_tracking.provisional(m_provisional);
+
+    const int64_t firstChanged = m_committedSize;
+
+    const auto append = [&](const FormantDecision& decision) {
+        m_formants.push_back(decision.time, toFrame(decision));
+    };
+
+    m_formants.truncate(m_committedSize);
+    for (const auto& decision : m_decisions) append(decision);
+    m_committedSize = m_formants.size();
+    for (const auto& decision : m_provisional) append(decision);
+
+    for (int i = 0; i < formantCount; ++i) {
+        m_formantSummaries[i].update(m_formants, firstChanged,
+                                     [i](const FormantFrame& frame) -> double {
+                                         return frame.freq[i];
+                                     });
+    }
+}
+
+void FormantController::setRootSolver(const RootSolver solver) {
+    std::lock_guard lockGuard(m_mutex);
+    if (solver == m_rootSolver.load(std::memory_order_relaxed)) return;
+    m_rootSolver.store(solver, std::memory_order_relaxed);
+    m_averageFrameMicros.store(-1, std::memory_order_relaxed);
+    forceClear(false);
+}
+
+RootSolver FormantController::rootSolver() const {
+    return m_rootSolver.load(std::memory_order_relaxed);
+}
+
+double FormantController::averageFrameMicros() const {
+    return m_averageFrameMicros.load(std::memory_order_relaxed);
 }
 
 FormantResults FormantController::getFormantsForRange(double timeMin, double timeMax,
@@ -147,19 +371,13 @@ FormantResults FormantController::getFormantsForRange(double timeMin, double tim
 
     FormantResults result;
 
-    // Track sample rate.
-    const double sampleRate = appState.audioTrack.sampleRate();
-
-    // Track length in samples.
-    const int trackSamples = appState.audioTrack.sampleCount();
-
-    for (int i = 0; i < m_times.size(); ++i) {
-        if (const double time = m_times[i]; time >= timeMin && time <= timeMax) {
-            const double frequency = m_frequencies[i];
+    // Stale frames in view are redone first.
+    m_staleRanges.setView(timeMin, timeMax);
 
-            result.times.push_back(time);
-            result.frequencies.push_back(frequency);
-        }
+    for (int i = 0; i < formantCount; ++i) {
+        m_formantSummaries[i].query(
+            m_formants, timeMin, timeMax, tpp, result.times, result.frequencies,
+            [i](const FormantFrame& frame) -> double { return frame.freq[i]; });
     }
 
     return result;
@@ -3,10 +3,14 @@
 
 #include <fftw3.h>
 
+#include <atomic>
 #include <mutex>
 #include <vector>
 
 #include "../resampler.h"
+#include "../staleranges.h"
+#include "../timeseries.h"
+#include "../timeseriessummary.h"
 #include "formants.h"
 
 namespace reformant {
@@ -28,20 +32,77 @@ class FormantController {
 
     FormantResults getFormantsForRange(double timeMin, double timeMax, double tpp);
 
+    // Root finder for the LPC polynomials. Changing it analyses the whole
+    // track again.
+    void setRootSolver(RootSolver solver);
+
+    [[nodiscard]] RootSolver rootSolver() const;
+
+    // Smoothed wall time to analyse one LPC frame, to compare root solvers on
+    // the same track. Only measured on frames analysed on the calling thread,
+    // negative until the first of them.
+    [[nodiscard]] double averageFrameMicros() const;
+
    private:
+    // Restart the analysis at the given track sample. Frames still in the
+    // tracker are committed first.
+    void restartAnalysis(int64_t origin, double Fs);
+
+    // Feed the track samples that arrived since the last update to the
+    // decimation filter, up to maxSamples of them.
+    void extendDownsampledSignal(int64_t trackSamples, int64_t maxSamples);
+
+    // Analyse one stale range again at the current rate and replace its
+    // frames, with a tracking lag worth of context frames on each side.
+    void recomputeStaleChunk(double Fs, int64_t firstSample, int64_t trackSamples);
+
+    // Replace the provisional tail of the series with the new decisions and
+    // the tracker's current guess for the frames it still holds.
+    void publish();
+
     AppState& appState;
 
     std::mutex m_mutex;
 
+    // Decimated copy of the track, sample j lines up with track sample
+    // m_dsOrigin + j * Fs / Fds. Only the samples that haven't been analysed
+    // yet are kept, scaled to 16-bit range for lpc_poles.
     Resampler m_dsResampler;
+    int64_t m_dsOrigin;
+    int64_t m_dsFedUntil;
+    std::vector<float> m_dsChunk;
+    std::vector<double> m_lpcSignal;
+    // Index in the decimated copy of m_lpcSignal[0], where the next frame starts.
+    int64_t m_lpcStart;
+    LpcContext m_lpcContext;
+    // One per worker, for backlogs analysed in parallel.
+    std::vector<LpcContext> m_lpcContexts;
+    // Written under m_mutex, read by the UI without it.
+    std::atomic<RootSolver> m_rootSolver;
+    std::atomic<double> m_averageFrameMicros;
 
-    int m_lastTime;
     double m_lastSampleRate;
-
-    std::vector<double> m_times;
-    std::vector<double> m_frequencies;
+    int64_t m_lastTrackSamples;
 
     FormantTracking m_tracking;
+    std::vector<FormantDecision> m_decisions;
+    std::vector<FormantDecision> m_provisional;
+
+    // One point per frame with all of its formants. Points from
+    // m_committedSize on are provisional.
+    TimeSeries<FormantFrame> m_formants;
+    // One summary per formant, indexed by formant number.
+    std::vector<TimeSeriesSummary> m_formantSummaries;
+    int64_t m_committedSize;
+
+    // Frames from before a sample rate change, redone a chunk per update.
+    StaleRanges m_staleRanges;
+    Resampler m_staleResampler;
+    std::vector<double> m_staleSignal;
+    LpcContext m_staleContext;
+    FormantTracking m_staleTracking;
+    std::vector<double> m_staleTimes;
+    std::vector<FormantFrame> m_staleFrames;
 };
 
 }  // namespace reformant
@@ -16,6 +16,9 @@
 
 #include "formants.h"
 
+#include <algorithm>
+#include <limits>
+
 using namespace reformant;
 
 static constexpr bool debug = false;
@@ -72,7 +75,14 @@ FormantTracking::FormantTracking(int nForm, double nomF1)
       fnom({500, 1500, 2500, 3500, 4500, 5500, 6500}),
       fmins({50, 400, 1000, 2000, 2000, 3000, 3000}),
       fmaxs({1500, 3500, 4500, 5000, 6000, 6000, 8000}),
-      doMerge(true) {}
+      doMerge(true),
+      m_dffact(0),
+      m_bfact(0),
+      m_ffact(0),
+      m_fbias(0),
+      m_lagFrames(-1),
+      m_head(0),
+      m_count(0) {}
 
 bool FormantTracking::canBe(const CandySt& st, int poleInd, int formInd) {
     return (st.fre[poleInd] >= fmins[formInd] && st.fre[poleInd] <= fmaxs[formInd]);
@@ -332,4 +342,214 @@ FormantTrack FormantTracking::track(const PoleArray& ps) {
     }
 
     return track;
-}
\ No newline at end of file
+}
+
+// -- Streaming
+
+void FormantTracking::reset(const int lagFrames, const double frameRate) {
+    if (nomF1 > 0.) {
+        setNominalFreqs(nomF1);
+    }
+
+    /* Same working values of the cost weights as track() */
+    m_fbias = F_BIAS / (.01 * frameRate);
+    m_dffact = (DF_FACT * .01) * frameRate;
+    m_bfact = BAND_FACT / (.01 * frameRate);
+    m_ffact = DFN_FACT / (.01 * frameRate);
+    if (F_MERGE > 1000.) doMerge = false;
+
+    pcan.resize(MAXCAN, nForm);
+
+    m_lagFrames = std::max(lagFrames, 0);
+    m_columns.resize(m_lagFrames + 1);
+    m_pathFreq.resize(nForm, m_lagFrames + 1);
+    m_pathBand.resize(nForm, m_lagFrames + 1);
+
+    clear();
+}
+
+void FormantTracking::clear() {
+    m_head = 0;
+    m_count = 0;
+}
+
+int FormantTracking::lagFrames() const { return m_lagFrames; }
+
+int FormantTracking::pendingFrames() const { return m_count; }
+
+bool FormantTracking::push(const double time, const Pole& pole,
+                           FormantDecision& decision) {
+    if (m_columns.empty()) return false;
+
+    // With a full lattice the slot of the oldest column is reused, decide it
+    // before it gets overwritten.
+    bool decided = false;
+    if (m_count == m_columns.size()) {
+        tracePath();
+        decision = pathDecision(0);
+        decided = true;
+
+        m_head = (m_head + 1) % m_columns.size();
+        --m_count;
+    }
+
+    const Column* previous = (m_count > 0) ? &column(m_count - 1) : nullptr;
+
+    ++m_count;
+    Column& current = column(m_count - 1);
+    FormLattice& cur = current.lattice;
+
+    current.time = time;
+    current.rms = pole.rms;
+    current.freq.assign(pole.freq.begin(), pole.freq.begin() + pole.npoles);
+    current.band.assign(pole.band.begin(), pole.band.begin() + pole.npoles);
+
+    /* moderate the cost of frequency jumps by the relative amplitude */
+    double rmsmax = std::numeric_limits<double>::lowest();
+    for (int i = 0; i < m_count; ++i) {
+        rmsmax = std::max(rmsmax, column(i).rms);
+    }
+    const double rmsdffact = (pole.rms / rmsmax) * m_dffact;
+
+    /* Get all likely mappings of the poles onto formants for this frame. */
+    ncan = 0;
+    if (pole.npoles > 0) {
+        getFcand(pole.npoles, pole.freq, nForm, pcan);
+
+        cur.prept.resize(ncan);
+        cur.cumerr.resize(ncan);
+        cur.cand.resize(ncan, nForm);
+        for (int j = 0; j < ncan; ++j) {
+            for (int k = 0; k < nForm; ++k) {
+                cur.cand(j, k) = pcan(j, k);
+            }
+        }
+    }
+    cur.ncand = ncan;
+
+    const int prevCount = (previous != nullptr) ? previous->lattice.ncand : 0;
+
+    for (int j = 0; j < ncan; ++j) { /* for each CURRENT mapping... */
+        double minErr = 0.;
+        int minCan = -1;
+        if (prevCount > 0) minErr = 2.0e30;
+
+        for (int k = 0; k < prevCount; ++k) { /* for each PREVIOUS map... */
+            const FormLattice& prev = previous->lattice;
+            double pfErr = 0.;
+            for (int l = 0; l < nForm; ++l) {
+                const int ic = cur.cand(j, l);
+                const int ip = prev.cand(k, l);
+                if (ic >= 0 && ip >= 0) {
+                    const double ftemp =
+                        2. * fabs(current.freq[ic] - previous->freq[ip]) /
+                        (current.freq[ic] + previous->freq[ip]);
+                    pfErr += ftemp * ftemp;
+                } else {
+                    pfErr += MISSING;
+                }
+            }
+            const double conErr = (rmsdffact * pfErr) + prev.cumerr[k];
+            if (conErr < minErr) {
+                minErr = conErr;
+                minCan = k;
+            }
+        }
+
+        cur.prept[j] = minCan;
+
+        /* Compute the local costs for this current mapping. */
+        double berr = 0.;
+        double ferr = 0.;
+        double fbias = 0.;
+        double merger = 0.;
+        for (int k = 0; k < nForm; ++k) {
+            const int ic = cur.cand(j, k);
+            if (ic >= 0) {
+                if (k == 0 && doMerge) { /* F1 candidate? */
+                    const int ic2 = cur.cand(j, 1);
+                    if (ic2 >= 0 && current.freq[ic] == current.freq[ic2]) {
+                        merger = F_MERGE;
+                    }
+                }
+                berr += current.band[ic];
+                ferr += (fabs(current.freq[ic] - fnom[k]) / fnom[k]);
+                fbias += current.freq[ic];
+            } else {
+                fbias += fnom[k];
+                berr += NOBAND;
+                ferr += MISSING;
+            }
+        }
+
+        cur.cumerr[j] =
+            (m_fbias * fbias) + (m_bfact * berr) + merger + (m_ffact * ferr) + minErr;
+    }
+
+    // Only differences between candidates matter, keep the sums from growing.
+    if (ncan > 0) {
+        const double minCumulative =
+            *std::min_element(cur.cumerr.begin(), cur.cumerr.begin() + ncan);
+        for (int j = 0; j < ncan; ++j) cur.cumerr[j] -= minCumulative;
+    }
+
+    return decided;
+}
+
+void FormantTracking::provisional(std::vector<FormantDecision>& decisions) {
+    if (m_count == 0) return;
+
+    tracePath();
+    for (int i = 0; i < m_count; ++i) {
+        decisions.push_back(pathDecision(i));
+    }
+}
+
+void FormantTracking::flush(std::vector<FormantDecision>& decisions) {
+    provisional(decisions);
+    clear();
+}
+
+FormantTracking::Column& FormantTracking::column(const int index) {
+    return m_columns[(m_head + index) % m_columns.size()];
+}
+
+void FormantTracking::tracePath() {
+    /* Same traceback as track(), over the pending columns only. */
+    int minCan = -1;
+    for (int i = m_count - 1; i >= 0; --i) {
+        const Column& c = column(i);
+        const FormLattice& l = c.lattice;
+
+        if (minCan < 0 && l.ncand > 0) { /* need to find best starting candidate? */
+            minCan = static_cast<int>(
+                std::min_element(l.cumerr.begin(), l.cumerr.begin() + l.ncand) -
+                l.cumerr.begin());
+        }
+
+        for (int j = 0; j < nForm; ++j) {
+            const int k = (minCan >= 0) ? l.cand(minCan, j) : -1;
+            if (k >= 0) {
+                m_pathFreq(j, i) = c.freq[k];
+                m_pathBand(j, i) = c.band[k];
+            } else if (minCan >= 0 && i < m_count - 1) {
+                m_pathFreq(j, i) = m_pathFreq(j, i + 1); /* replicate backwards */
+                m_pathBand(j, i) = m_pathBand(j, i + 1);
+            } else {
+                m_pathFreq(j, i) = -1000.0;
+                m_pathBand(j, i) = NOBAND;
+            }
+        }
+
+        if (minCan >= 0) minCan = l.prept[minCan];
+    }
+}
+
+FormantDecision FormantTracking::pathDecision(const int index) {
+    FormantDecision decision{column(index).time, {}, {}};
+    for (int j = 0; j < nForm; ++j) {
+        decision.freq[j] = m_pathFreq(j, index);
+        decision.band[j] = m_pathBand(j, index);
+    }
+    return decision;
+}
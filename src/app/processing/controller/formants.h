@@ -23,12 +23,55 @@ struct FormantTrack {
     double sampleRate;
 };
 
+// Formants of one analysis frame, as stored for display.
+struct FormantFrame {
+    // -1000 if the formant is missing.
+    std::array<float, MAXFORMANTS> freq;
+    std::array<float, MAXFORMANTS> band;
+};
+
+struct FormantDecision {
+    double time;
+    // -1000 if the formant is missing.
+    std::array<double, MAXFORMANTS> freq;
+    std::array<double, MAXFORMANTS> band;
+};
+
 class FormantTracking {
    public:
     FormantTracking(int nForm, double nomF1);
 
     FormantTrack track(const PoleArray& ps);
 
+    // -- Streaming.
+    // The lattice only holds the last lagFrames + 1 frames, in a ring of
+    // columns. Each pushed frame extends the best mappings, and the oldest
+    // frame is decided by tracing back from the best current candidate, so a
+    // decision comes out lagFrames frames after its frame went in. Jumps are
+    // weighted by RMS relative to the loudest frame in the lattice instead of
+    // the loudest frame of the whole track.
+
+    // Empty the lattice and size it for the given lag. frameRate is the number
+    // of LPC frames per second.
+    void reset(int lagFrames, double frameRate);
+
+    // Drop pending frames, keep the sizes.
+    void clear();
+
+    [[nodiscard]] int lagFrames() const;
+    [[nodiscard]] int pendingFrames() const;
+
+    // Add the next frame. Returns true if the oldest pending frame was decided.
+    bool push(double time, const Pole& pole, FormantDecision& decision);
+
+    // Best guess for the pending frames from the current state, they can still
+    // change. Decisions are appended in time order.
+    void provisional(std::vector<FormantDecision>& decisions);
+
+    // Decide all pending frames from the best current state and empty the
+    // lattice. Decisions are appended in time order.
+    void flush(std::vector<FormantDecision>& decisions);
+
    private:
     // -- Structs.
 
@@ -47,6 +90,15 @@ class FormantTracking {
         std::vector<double> cumerr; /* cum. errors associated with each cand. */
     };
 
+    /* a frame of the streaming lattice with its poles */
+    struct Column {
+        double time;
+        double rms;
+        std::vector<double> freq;
+        std::vector<double> band;
+        FormLattice lattice;
+    };
+
     // -- Fields.
 
     int nForm;
@@ -64,6 +116,21 @@ class FormantTracking {
     vector2d<int> pcan;
     std::vector<FormLattice> fl;
 
+    // Streaming state, see reset().
+    double m_dffact;
+    double m_bfact;
+    double m_ffact;
+    double m_fbias;
+
+    int m_lagFrames;
+    std::vector<Column> m_columns;
+    int m_head;
+    int m_count;
+
+    // Formants on the best path through the pending columns.
+    vector2d<double> m_pathFreq;
+    vector2d<double> m_pathBand;
+
     // -- Methods.
 
     /* Can this pole be this freq? */
@@ -82,6 +149,14 @@ class FormantTracking {
 
     /* Find the maximum in the "stationarity" function (stored in rms) */
     double getStatMax(const PoleArray& ps);
+
+    /* Pending column by index, 0 is the oldest. */
+    Column& column(int index);
+
+    /* Trace the best path back from the newest column into m_pathFreq/Band. */
+    void tracePath();
+
+    FormantDecision pathDecision(int index);
 };
 
 }  // namespace reformant
@@ -1,42 +1,38 @@
 #include "pitchcontroller.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <complex>
 #include <iostream>
-#include <limits>
+#include <memory>
 
 #include "../../state.h"
+#include "../thread/workerpool.h"
+#include "../util/simd.h"
 #include "../util/util.h"
 
 using namespace reformant;
 
-namespace {
-void subtractReferenceMean(std::vector<float>& s);
-
-std::vector<float> downsampleSignal(const std::vector<float>& s, int off, int len,
-                                    double Fs, double Fds, Resampler& resampler);
-
-void calculateDownsampledNCCF(const std::vector<float>& dss, int dsn, int dsK1, int dsK2,
-                              std::vector<double>& dsNCCF);
-
-void calculateOriginalNCCF(const std::vector<float>& s, int off, double Fs, double Fds,
-                           int n, int K,
-                           const std::vector<std::pair<double, double> >& dsPeaks,
-                           std::vector<double>& nccf);
-
-std::vector<std::pair<double, double> > findPeaksWithThreshold(
-    const std::vector<double>& nccf, double cand_tr, int n_cands, bool paraInterp);
-} // namespace
-
 PitchController::PitchController(AppState& appState)
     : appState(appState),
       m_dsResampler(4),
+      m_dsOrigin(0),
+      m_dsFedUntil(0),
+      m_dsRate(-1),
+      m_estimatorType(PitchEstimator_Nccf),
+      m_nccfMethod(NccfMethod_Fft),
+      m_hopMs(10),
+      m_averageFrameMicros(-1),
+      m_trackingLagMs(200),
+      m_trackerNeedsReset(true),
       m_lastTime(0),
+      m_frameLatency(0),
       m_lastSampleRate(-1),
-      m_minSilenceRunLength(0),
-      m_minVoicingRunLength(0),
-      m_pitchBuffer(std::max(m_minSilenceRunLength, m_minVoicingRunLength) + 1,
-                    PitchPoint{0, -1}) {
+      m_lastTrackSamples(0),
+      m_staleRanges(staleChunkLength),
+      m_staleResampler(4),
+      m_voicingCursor(0) {
     F0min = 50;
     F0max = 600;
     cand_tr = 0.3;
@@ -54,29 +50,28 @@ PitchController::PitchController(AppState& appState)
 void PitchController::forceClear(bool lock) {
     if (lock) m_mutex.lock();
 
-    m_dsResampler.reset();
-    m_dsResampler.skipZeros();
+    // Restarted from the beginning on the next update.
+    m_dsSignal.clear();
+    m_dsRate = -1;
 
     m_lastTime = 0;
     m_lastSampleRate = -1;
 
-    m_times.clear();
     m_pitches.clear();
+    m_pitchSummary.clear();
+    m_voicingCursor = 0;
+
+    m_trackerNeedsReset = true;
+    m_lastTrackSamples = 0;
 
-    m_minSilenceRunLength = 0;
-    m_minVoicingRunLength = 0;
-    std::fill(m_pitchBuffer.begin(), m_pitchBuffer.end(), PitchPoint{0, -1});
+    m_staleRanges.clear();
 
     if (lock) m_mutex.unlock();
 }
 
 void PitchController::updateIfNeeded() {
-    using namespace std::chrono_literals;
-
-    // Just return if we couldn't lock, this isn't important because it's
-    // ran periodically, and it avoids a potential deadlock.
-    std::unique_lock trackLock(appState.audioTrack.mutex(), 50ms);
-    if (!trackLock.owns_lock()) return;
+    // Appends don't block the lease, only structural changes to the track do.
+    const auto trackLease = appState.audioTrack.lease();
 
     std::lock_guard lockGuard(m_mutex);
 
@@ -84,246 +79,388 @@ void PitchController::updateIfNeeded() {
     const double Fs = appState.audioTrack.sampleRate();
 
     if (Fs != m_lastSampleRate) {
-        m_lastTime = std::round((m_lastTime / m_lastSampleRate) * Fs);
+        if (m_lastSampleRate > 0 && m_lastTime > 0) {
+            // Keep what was analysed at the old rate on display and redo it
+            // progressively. The frames still in the tracker won't get any
+            // context at the old rate anymore, commit them now.
+            const int64_t firstNewPitch = m_pitches.size();
+            m_decisions.clear();
+            m_tracker.flush(m_decisions);
+            for (const auto& [time, pitch] : m_decisions) {
+                if (pitch > 0) m_pitches.push_back(time, pitch);
+            }
+            m_pitchSummary.update(m_pitches, firstNewPitch);
+            m_trackerNeedsReset = true;
+
+            m_staleRanges.mark(0, (m_lastTime - m_frameLatency) / m_lastSampleRate);
+        }
+
+        m_lastTime = std::llround((m_lastTime / m_lastSampleRate) * Fs);
         m_lastSampleRate = Fs;
+        // The track was resampled, so the decimated copy is stale.
+        m_dsRate = -1;
     }
 
     // Track length in samples.
-    const int trackSamples = appState.audioTrack.sampleCount();
+    const int64_t trackSamples = appState.audioTrack.sampleCount();
 
-    if (!m_times.empty() && trackSamples < m_lastTime) {
+    if (!m_pitches.empty() && trackSamples < m_lastTime) {
         return;
     }
 
-    // Correlation window size. (secs)
-    constexpr double w = 0.0075;
-
-    const int n = static_cast<int>(std::round(w * Fs));
-    const int K = static_cast<int>(std::round(Fs / F0min));
-    const int wl = n + K;
+    const int64_t firstSample = appState.audioTrack.firstSample();
+    dropBefore(firstSample, Fs);
 
     const double Fds = std::round(Fs / std::round(Fs / (4 * F0max)));
-    const int dsn = static_cast<int>(std::round(w * Fds));
-    const int dsK1 = static_cast<int>(std::round(Fds / F0max));
-    const int dsK2 = static_cast<int>(std::round(Fds / F0min));
-    const int dswl = dsn + dsK2;
 
-    const double beta = lag_wt / (Fs / F0min);
+    // All workers run the same estimator, one instance each.
+    WorkerPool& pool = *appState.workerPool;
+    while (m_estimators.size() < pool.workerCount()) {
+        m_estimators.push_back(makePitchEstimator(m_estimatorType, m_nccfMethod));
+    }
+    const PitchEstimatorParams estimatorParams{Fs, Fds, F0min, F0max, cand_tr, n_cands};
+    for (auto& estimator : m_estimators) estimator->configure(estimatorParams);
+
+    const int wl = m_estimators.front()->windowLength();
+    const int dswl = m_estimators.front()->decimatedWindowLength();
 
     const int J = static_cast<int>(std::round(0.03 * Fs));
 
-    const int trackIndex0 = m_lastTime;
+    const int64_t trackIndex0 = m_lastTime;
 
-    auto s = appState.audioTrack.data(trackIndex0, trackSamples - trackIndex0 - 1);
+    // A long backlog, like a file that was just opened, is caught up with over
+    // several updates.
+    const int64_t analysisEnd = std::min<int64_t>(
+        trackSamples,
+        trackIndex0 + std::llround(maxUpdateDuration * pool.workerCount() * Fs));
 
-    subtractReferenceMean(s);
+    // Decimate again from where we are if the copy went stale. Estimators that
+    // work at the full rate don't need the copy at all.
+    if (dswl > 0) {
+        if (Fds != m_dsRate || m_dsFedUntil > trackSamples) {
+            restartDownsampledSignal(trackIndex0, Fs, Fds);
+        }
+        extendDownsampledSignal(analysisEnd);
+    } else if (m_dsRate > 0) {
+        m_dsSignal.clear();
+        m_dsRate = -1;
+    }
 
-    int is = 0;
+    // Only the decimated copy lags behind the track.
+    m_frameLatency = (dswl > 0) ? m_dsResampler.inputLatency() : 0;
+
+    // The signal starts up to J samples early for the RMS before the first
+    // frame. Reuse the same buffer across updates to avoid reallocating.
+    const int lead = static_cast<int>(std::min<int64_t>(trackIndex0 - firstSample, J));
+    auto& s = m_signal;
+    const auto view = appState.audioTrack.view(trackIndex0 - lead,
+                                               analysisEnd - trackIndex0 - 1 + lead);
+    s.resize(view.size());
+    view.copyTo(s.data());
+
+    util::subtractMean(s);
+
+    const int hop =
+        (m_hopMs > 0) ? std::max(static_cast<int>(std::round(m_hopMs * Fs / 1000)), 1)
+                      : wl;
+
+    const FrameParams params{Fs, Fds, J, trackIndex0, lead, &m_signal, &m_dsSignal,
+                             m_dsOrigin, m_frameLatency};
+
+    // Count the frames that are ready: the full window must be in the track and
+    // the decimation filter must have caught up with it.
+    int frameCount = 0;
+    for (int is = 0; lead + is + wl < s.size(); is += hop) {
+        if (dswl > 0 && downsampledIndex(params, is) + dswl > m_dsSignal.size()) {
+            break;
+        }
+        ++frameCount;
+    }
 
-    std::vector<double> dsNCCF(dsK2 + 1);
-    std::vector<double> nccf(K + 1);
+    // Frames are independent of each other, evaluate them in parallel.
+    const auto evaluationStart = std::chrono::steady_clock::now();
+
+    if (m_frames.size() < frameCount) m_frames.resize(frameCount);
+    pool.parallelFor(frameCount, [&](const int frame, const int worker) {
+        evaluateFrame(*m_estimators[worker], params, frame * hop, m_frames[frame]);
+    });
+
+    if (frameCount > 0) {
+        const std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - evaluationStart;
+        const double frameMicros = elapsed.count() / frameCount;
+        const double average = m_averageFrameMicros.load(std::memory_order_relaxed);
+        m_averageFrameMicros.store(
+            (average >= 0) ? 0.9 * average + 0.1 * frameMicros : frameMicros,
+            std::memory_order_relaxed);
+    }
 
-    while (is + wl < s.size()) {
-        auto dss = downsampleSignal(s, is, wl, Fs, Fds, m_dsResampler);
-        if (dss.size() < dswl) {
-            dss.resize(dswl, 0);
-        }
-        calculateDownsampledNCCF(dss, dsn, dsK1, dsK2, dsNCCF);
-        auto dsPeaks = findPeaksWithThreshold(dsNCCF, cand_tr, n_cands, false);
-
-        const double time = (trackIndex0 + is - m_dsResampler.inputLatency()) / Fs;
-        double pitch = -1;
-
-        if (!dsPeaks.empty()) {
-            calculateOriginalNCCF(s, is, Fs, Fds, n, K, dsPeaks, nccf);
-            auto peaks = findPeaksWithThreshold(nccf, cand_tr, n_cands, false);
-
-            // Find the candidate with the lowest cost.
-            int minLag = 0;
-            double minCost = std::numeric_limits<double>::max();
-            double maxVal = std::numeric_limits<double>::min();
-
-            for (const auto& [k, y] : peaks) {
-                const double localCost = 1 - y * (1 - beta * k);
-                if (localCost < minCost) {
-                    minLag = k;
-                    minCost = localCost;
-                }
-                if (y > maxVal) {
-                    maxVal = y;
-                }
-            }
+    const int64_t firstNewPitch = m_pitches.size();
 
-            if (vo_bias + maxVal >= minCost) {
-                const double Linterp = util::parabolicInterpolation(nccf, minLag).first;
-                pitch = Fs / Linterp;
-            }
+    // Tracking carries state from frame to frame, so it runs in order.
+    const int lagFrames = static_cast<int>(std::round(m_trackingLagMs * Fs / 1000 / hop));
+    if (m_tracker.lagFrames() != lagFrames || m_trackerNeedsReset) {
+        m_tracker.reset(lagFrames, n_cands);
+        m_trackerNeedsReset = false;
+    }
+    m_tracker.setCosts(PitchTrackerCosts{Fs, F0min, lag_wt, freq_wt, vtran_c, vtr_a_c,
+                                         vtr_s_c, vo_bias, doubl_c});
+
+    m_decisions.clear();
+    for (int frame = 0; frame < frameCount; ++frame) {
+        PitchDecision decision;
+        if (m_tracker.push(m_frames[frame], decision)) {
+            m_decisions.push_back(decision);
         }
+    }
 
-        is += wl;
-
-        m_pitchBuffer.back() = PitchPoint{time, pitch};
-
-        // Check voicing run length.
-        auto& bufferFront = m_pitchBuffer.front();
-        if (bufferFront.pitch < 0) {
-            bool isTooShort = false;
-            double replacePitch;
-            for (int k = 1; k < m_minSilenceRunLength; ++k) {
-                if (m_pitchBuffer[k].pitch > 0) {
-                    isTooShort = true;
-                    replacePitch = m_pitchBuffer[k].pitch;
-                    break;
-                }
-            }
-            if (isTooShort) {
-                bufferFront.pitch = replacePitch;
-            }
-        }
-        if (bufferFront.pitch > 0) {
-            bool isLongEnough = true;
-            for (int k = 1; k < m_minVoicingRunLength; ++k) {
-                if (m_pitchBuffer[k].pitch < 0) {
-                    isLongEnough = false;
-                    break;
-                }
-            }
-            if (isLongEnough) {
-                m_times.push_back(bufferFront.time);
-                m_pitches.push_back(bufferFront.pitch);
-            }
-        }
+    // Without new audio there is nothing left to wait for.
+    if (frameCount == 0 && trackSamples == m_lastTrackSamples) {
+        m_tracker.flush(m_decisions);
+    }
+    m_lastTrackSamples = trackSamples;
 
-        std::rotate(m_pitchBuffer.begin(), m_pitchBuffer.begin() + 1,
-                    m_pitchBuffer.end());
+    for (const auto& [time, pitch] : m_decisions) {
+        if (pitch > 0) {
+            m_pitches.push_back(time, pitch);
+        }
     }
 
-    m_lastTime += is;
+    m_pitchSummary.update(m_pitches, firstNewPitch);
+
+    m_lastTime += frameCount * hop;
+
+    recomputeStaleChunk(Fs, Fds, hop, firstSample, trackSamples);
 }
 
-namespace {
-void subtractReferenceMean(std::vector<float>& s) {
-    double mu = 0;
-    for (int j = 0; j < s.size(); ++j) mu += s[j];
-    mu /= s.size();
-    for (int j = 0; j < s.size(); ++j) s[j] -= mu;
+int64_t PitchController::downsampledIndex(const FrameParams& params,
+                                          const int is) const {
+    return std::llround((params.trackIndex0 + is - params.dsOrigin) * params.Fds /
+                        params.Fs);
 }
 
-std::vector<float> downsampleSignal(const std::vector<float>& s, const int off,
-                                    const int len, const double Fs, const double Fds,
-                                    Resampler& resampler) {
-    resampler.setRate(Fs, Fds);
-    resampler.reset();
-    resampler.skipZeros();
-    return resampler.process(s, off, len);
+void PitchController::evaluateFrame(PitchEstimator& estimator, const FrameParams& params,
+                                    const int is, PitchFrame& frame) const {
+    const auto& [Fs, Fds, J, trackIndex0, lead, signal, dsSignal, dsOrigin, latency] =
+        params;
+
+    frame.time = (trackIndex0 + is - latency) / Fs;
+    frame.rmsRatio = rmsRatio(*signal, lead + is, J);
+
+    const int64_t dsIndex =
+        (estimator.decimatedWindowLength() > 0) ? downsampledIndex(params, is) : 0;
+    estimator.estimate(PitchFrameInput{signal->data() + lead + is, dsSignal, dsIndex},
+                       frame);
 }
 
-void calculateDownsampledNCCF(const std::vector<float>& dss, const int dsn,
-                              const int dsK1, const int dsK2,
-                              std::vector<double>& dsNCCF) {
-    double dse0 = 0;
-    for (int l = 0; l < dsn; ++l) {
-        dse0 += dss[l] * dss[l];
+double PitchController::rmsRatio(const std::vector<float>& signal, const int is,
+                                 const int J) const {
+    // RMS over J samples on each side of signal[is], as far as the signal
+    // goes. The floor keeps silence from blowing up the ratio.
+    const int size = static_cast<int>(signal.size());
+    const int before = std::min(is, J);
+    const int after = std::min(size - is, J);
+
+    if (before <= 0 || after <= 0) {
+        return 1;
     }
 
-    for (int k = dsK1; k <= dsK2; ++k) {
-        double p(0), q(0);
+    const double floor = 1 / a_fact;
+    const double rmsBefore =
+        std::sqrt(util::sumOfSquares(signal.data() + is - before, before) / before);
+    const double rmsAfter =
+        std::sqrt(util::sumOfSquares(signal.data() + is, after) / after);
+    return (rmsAfter + floor) / (rmsBefore + floor);
+}
 
-        for (int j = 0; j < dsn; ++j) {
-            p += dss[j] * dss[j + k];
-        }
+void PitchController::restartDownsampledSignal(const int64_t origin, const double Fs,
+                                               const double Fds) {
+    m_dsResampler.setRate(Fs, Fds);
+    m_dsResampler.reset();
+    m_dsResampler.skipZeros();
 
-        for (int l = k; l < k + dsn; ++l) {
-            q += dss[l] * dss[l];
-        }
+    m_dsSignal.clear();
+    m_dsOrigin = origin;
+    m_dsFedUntil = origin;
+    m_dsRate = Fds;
+}
 
-        q = sqrt(dse0 * q);
+void PitchController::extendDownsampledSignal(const int64_t analysisEnd) {
+    if (m_dsFedUntil >= analysisEnd) return;
 
-        dsNCCF[k] = p / q;
-    }
+    const auto view =
+        appState.audioTrack.view(m_dsFedUntil, analysisEnd - m_dsFedUntil);
+    view.forEachSpan([&](const std::span<const float> span) {
+        m_dsResampler.process(m_dsChunk, span.data(), static_cast<int>(span.size()));
+        m_dsSignal.append(m_dsChunk);
+    });
+
+    m_dsFedUntil = analysisEnd;
 }
 
-void calculateOriginalNCCF(const std::vector<float>& s, const int off, const double Fs,
-                           const double Fds, const int n, const int K,
-                           const std::vector<std::pair<double, double> >& dsPeaks,
-                           std::vector<double>& nccf) {
-    std::vector<int> lagsToCalculate;
+void PitchController::dropBefore(const int64_t firstSample, const double Fs) {
+    if (firstSample == 0) return;
 
-    for (const auto& [dsk, y] : dsPeaks) {
-        const int k = static_cast<int>(std::round((Fs * dsk) / Fds));
+    const double firstTime = firstSample / Fs;
+    m_pitches.dropBefore(firstTime);
+    m_pitchSummary.dropBefore(firstTime);
 
-        if (k >= 0 && k <= K) lagsToCalculate.push_back(k);
+    m_staleRanges.dropBefore(firstTime);
 
-        for (int l = 1; l <= 3; ++l) {
-            if (k - l >= 0 && k - l <= K) lagsToCalculate.push_back(k - l);
-            if (k + l >= 0 && k + l <= K) lagsToCalculate.push_back(k + l);
-        }
+    // Fell behind the rolling window, carry on from its start.
+    if (m_lastTime < firstSample) {
+        m_lastTime = firstSample;
+        m_dsRate = -1;
+        m_trackerNeedsReset = true;
     }
 
-    std::sort(lagsToCalculate.begin(), lagsToCalculate.end());
-    auto last = std::unique(lagsToCalculate.begin(), lagsToCalculate.end());
-    lagsToCalculate.erase(last, lagsToCalculate.end());
+    if (m_dsRate > 0) {
+        m_dsSignal.dropBefore(std::llround((firstSample - m_dsOrigin) * m_dsRate / Fs));
+    }
+}
 
-    std::fill(nccf.begin(), nccf.end(), 0);
+void PitchController::recomputeStaleChunk(const double Fs, const double Fds,
+                                          const int hop, const int64_t firstSample,
+                                          const int64_t trackSamples) {
+    double timeMin, timeMax;
+    if (!m_staleRanges.take(timeMin, timeMax)) return;
 
-    double e0; {
-        int j = 0;
-        double v = 0;
-        for (int l = j; l < j + n; ++l) {
-            v += s[off + l] * s[off + l];
-        }
-        e0 = v;
+    const int wl = m_estimators.front()->windowLength();
+    const int dswl = m_estimators.front()->decimatedWindowLength();
+    const int J = static_cast<int>(std::round(0.03 * Fs));
+    const int latency = m_frameLatency;
+    const int lagFrames = static_cast<int>(std::round(m_trackingLagMs * Fs / 1000 / hop));
+
+    // First frame in the range, then up to lagFrames before and after it.
+    const int64_t first =
+        std::max<int64_t>(std::llround(std::ceil(timeMin * Fs)) + latency, firstSample);
+    const int64_t begin =
+        first - std::min<int64_t>(lagFrames, (first - firstSample) / hop) * hop;
+
+    int frameCount = 0;
+    int framesAfter = 0;
+    for (int64_t index = begin; index + wl < trackSamples - 1; index += hop) {
+        const bool isAfter = (index - latency) / Fs >= timeMax;
+        if (isAfter && framesAfter++ >= lagFrames) break;
+        ++frameCount;
     }
 
-    for (const int k : lagsToCalculate) {
-        double p(0), q(0);
+    if (frameCount == 0) return;
+
+    const int lead = static_cast<int>(std::min<int64_t>(begin - firstSample, J));
+    auto& s = m_staleSignal;
+    const auto view =
+        appState.audioTrack.view(begin - lead, lead + (frameCount - 1) * hop + wl + J);
+    s.resize(view.size());
+    view.copyTo(s.data());
+
+    util::subtractMean(s);
+
+    if (dswl > 0) {
+        m_staleResampler.setRate(Fs, Fds);
+        m_staleResampler.reset();
+        m_staleResampler.skipZeros();
+        m_staleDsSignal.clear();
+
+        // A bit past the last frame, for the filter delay.
+        const int64_t signalEnd = begin + static_cast<int64_t>(s.size()) - lead;
+        const int64_t end = std::min<int64_t>(
+            trackSamples, signalEnd + 2 * m_staleResampler.inputLatency());
+        appState.audioTrack.view(begin, end - begin)
+            .forEachSpan([&](const std::span<const float> span) {
+                m_staleResampler.process(m_dsChunk, span.data(),
+                                         static_cast<int>(span.size()));
+                m_staleDsSignal.append(m_dsChunk);
+            });
+    }
 
-        for (int j = 0; j < n; ++j) {
-            p += s[off + j] * s[off + j + k];
-        }
+    const FrameParams params{Fs, Fds, J, begin, lead, &m_staleSignal, &m_staleDsSignal,
+                             begin, latency};
 
-        for (int l = k; l < k + n; ++l) {
-            q += s[off + l] * s[off + l];
+    if (dswl > 0) {
+        while (frameCount > 0 &&
+               downsampledIndex(params, (frameCount - 1) * hop) + dswl >
+                   m_staleDsSignal.size()) {
+            --frameCount;
         }
-
-        q = sqrt(e0 * q);
-
-        nccf[k] = p / q;
     }
-}
 
-std::vector<std::pair<double, double> > findPeaksWithThreshold(
-    const std::vector<double>& nccf, const double cand_tr, const int n_cands,
-    const bool paraInterp) {
-    double max = std::numeric_limits<double>::lowest();
-    for (int i = 0; i < nccf.size(); ++i) {
-        if (nccf[i] > max) {
-            max = nccf[i];
+    WorkerPool& pool = *appState.workerPool;
+    if (m_frames.size() < frameCount) m_frames.resize(frameCount);
+    pool.parallelFor(frameCount, [&](const int frame, const int worker) {
+        evaluateFrame(*m_estimators[worker], params, frame * hop, m_frames[frame]);
+    });
+
+    m_staleTracker.reset(lagFrames, n_cands);
+    m_staleTracker.setCosts(PitchTrackerCosts{Fs, F0min, lag_wt, freq_wt, vtran_c,
+                                              vtr_a_c, vtr_s_c, vo_bias, doubl_c});
+
+    m_decisions.clear();
+    for (int frame = 0; frame < frameCount; ++frame) {
+        PitchDecision decision;
+        if (m_staleTracker.push(m_frames[frame], decision)) {
+            m_decisions.push_back(decision);
+        }
+    }
+    m_staleTracker.flush(m_decisions);
+
+    // The context frames only steer the path, their results stay as they are.
+    m_staleTimes.clear();
+    m_stalePitches.clear();
+    for (const auto& [time, pitch] : m_decisions) {
+        if (pitch > 0 && time >= timeMin && time < timeMax) {
+            m_staleTimes.push_back(time);
+            m_stalePitches.push_back(pitch);
         }
     }
 
-    const double threshold = cand_tr * max;
+    const int64_t sizeChange =
+        m_pitches.replaceRange(timeMin, timeMax, m_staleTimes, m_stalePitches);
+    m_pitchSummary.updateRange(m_pitches, timeMin, timeMax, sizeChange);
+}
 
-    auto allPeaks = util::findPeaks(nccf);
+void PitchController::setNccfMethod(const NccfMethod method) {
+    std::lock_guard lockGuard(m_mutex);
+    m_nccfMethod = method;
+    // Made again with the new method on the next update.
+    m_estimators.clear();
+}
 
-    std::vector<std::pair<double, double> > peaks;
+NccfMethod PitchController::nccfMethod() const { return m_nccfMethod; }
 
-    for (const int k : allPeaks) {
-        if (k >= 0 && k < nccf.size() && nccf[k] > threshold) {
-            peaks.push_back(util::parabolicInterpolation(nccf, k));
-        }
-    }
+void PitchController::setEstimatorType(const PitchEstimatorType type) {
+    std::lock_guard lockGuard(m_mutex);
+    if (type == m_estimatorType) return;
+    m_estimatorType = type;
+    m_estimators.clear();
+    m_averageFrameMicros.store(-1, std::memory_order_relaxed);
+    forceClear(false);
+}
 
-    std::sort(peaks.begin(), peaks.end(),
-              [](const auto& a, const auto& b) { return a.second > b.second; });
+PitchEstimatorType PitchController::estimatorType() const { return m_estimatorType; }
 
-    if (peaks.size() > n_cands - 1) {
-        peaks.erase(std::next(peaks.begin(), n_cands - 1), peaks.end());
-    }
+double PitchController::averageFrameMicros() const {
+    return m_averageFrameMicros.load(std::memory_order_relaxed);
+}
 
-    return peaks;
+void PitchController::setHopMs(const double hopMs) {
+    std::lock_guard lockGuard(m_mutex);
+    if (hopMs == m_hopMs) return;
+    m_hopMs = hopMs;
+    // Recompute the whole track so that frames stay evenly spaced.
+    forceClear(false);
 }
-} // namespace
+
+double PitchController::hopMs() const { return m_hopMs; }
+
+void PitchController::setTrackingLagMs(const double lagMs) {
+    std::lock_guard lockGuard(m_mutex);
+    if (lagMs == m_trackingLagMs) return;
+    m_trackingLagMs = lagMs;
+    forceClear(false);
+}
+
+double PitchController::trackingLagMs() const { return m_trackingLagMs; }
 
 PitchResults PitchController::getPitchesForRange(double timeMin, double timeMax,
                                                  double timePerPixel) {
@@ -331,21 +468,11 @@ PitchResults PitchController::getPitchesForRange(double timeMin, double timeMax,
 
     PitchResults result;
 
-    // Track sample rate.
-    const double sampleRate = appState.audioTrack.sampleRate();
-
-    // Track length in samples.
-    const int trackSamples = appState.audioTrack.sampleCount();
+    // Stale results in view are redone first.
+    m_staleRanges.setView(timeMin, timeMax);
 
-    for (int i = 0; i < m_times.size(); ++i) {
-        const double time = m_times[i];
-        if (time >= timeMin && time <= timeMax) {
-            const double pitch = m_pitches[i];
-
-            result.times.push_back(time);
-            result.pitches.push_back(pitch);
-        }
-    }
+    m_pitchSummary.query(m_pitches, timeMin, timeMax, timePerPixel, result.times,
+                         result.pitches);
 
     return result;
 }
@@ -353,32 +480,38 @@ PitchResults PitchController::getPitchesForRange(double timeMin, double timeMax,
 static inline double voicing(double pitch) { return pitch < 0 ? 0 : 1; }
 
 double PitchController::getInterpolatedVoicing(double x) {
-    const int n = m_times.size();
+    std::lock_guard lockGuard(m_mutex);
+
+    const int64_t first = m_pitches.begin();
+    const int64_t n = m_pitches.size();
 
-    int indexLeft, indexRight;
+    if (m_pitches.empty()) {
+        return 0;
+    }
+
+    const int64_t after = m_pitches.upperBound(x, m_voicingCursor);
+    m_voicingCursor = after;
+
+    int64_t indexLeft, indexRight;
 
-    if (x < m_times[0]) {
-        indexLeft = indexRight = 0;
-    } else if (x >= m_times.back()) {
+    if (after == first) {
+        indexLeft = indexRight = first;
+    } else if (after == n) {
         indexLeft = indexRight = n - 1;
     } else {
-        for (int i = 0; i < n - 1; ++i) {
-            if (m_times[i] <= x && x < m_times[i + 1]) {
-                indexLeft = i;
-                indexRight = i + 1;
-            }
-        }
+        indexLeft = after - 1;
+        indexRight = after;
     }
 
     if (indexLeft == indexRight) {
-        return (m_pitches[indexLeft] < 0) ? 0 : 1;
+        return (m_pitches.value(indexLeft) < 0) ? 0 : 1;
     }
 
-    const double x0 = m_times[indexLeft];
-    const double x1 = m_times[indexRight];
+    const double x0 = m_pitches.time(indexLeft);
+    const double x1 = m_pitches.time(indexRight);
 
-    const double p0 = voicing(m_pitches[indexLeft]);
-    const double p1 = voicing(m_pitches[indexRight]);
+    const double p0 = voicing(m_pitches.value(indexLeft));
+    const double p1 = voicing(m_pitches.value(indexRight));
 
     constexpr double t0 = 0;
     constexpr double t1 = 1;
@@ -397,12 +530,13 @@ double PitchController::getInterpolatedVoicing(double x) {
     const double dp1 = p1 - p0;
     const double dx1 = x1 - x0;
 
-    const double dp0 = (indexLeft > 0) ? p0 - voicing(m_pitches[indexLeft - 1]) : dp1;
-    const double dx0 = (indexLeft > 0) ? x0 - m_times[indexLeft - 1] : dx1;
+    const double dp0 =
+        (indexLeft > first) ? p0 - voicing(m_pitches.value(indexLeft - 1)) : dp1;
+    const double dx0 = (indexLeft > first) ? x0 - m_pitches.time(indexLeft - 1) : dx1;
 
     const double dp2 =
-        (indexRight < n - 1) ? voicing(m_pitches[indexRight + 1]) - p1 : dp1;
-    const double dx2 = (indexRight < n - 1) ? m_times[indexRight + 1] - x1 : dx1;
+        (indexRight < n - 1) ? voicing(m_pitches.value(indexRight + 1)) - p1 : dp1;
+    const double dx2 = (indexRight < n - 1) ? m_pitches.time(indexRight + 1) - x1 : dx1;
 
     const double df0 = dp0 / dx0;
     const double df1 = dp1 / dx1;
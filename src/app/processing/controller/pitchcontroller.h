@@ -3,10 +3,19 @@
 
 #include <fftw3.h>
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
 
+#include "../pitch/nccf.h"
+#include "../pitch/pitchestimator.h"
+#include "../pitch/pitchtracker.h"
 #include "../resampler.h"
+#include "../samplestore.h"
+#include "../staleranges.h"
+#include "../timeseries.h"
+#include "../timeseriessummary.h"
 
 namespace reformant {
 
@@ -29,26 +38,128 @@ class PitchController {
 
     double getInterpolatedVoicing(double time);
 
+    void setEstimatorType(PitchEstimatorType type);
+
+    [[nodiscard]] PitchEstimatorType estimatorType() const;
+
+    // Correlation kernels, used by every estimator.
+    void setNccfMethod(NccfMethod method);
+
+    [[nodiscard]] NccfMethod nccfMethod() const;
+
+    // Time between analysis frames. Zero means one correlation window.
+    void setHopMs(double hopMs);
+
+    [[nodiscard]] double hopMs() const;
+
+    // How far the pitch tracker looks ahead before committing to a frame.
+    // Longer lags give smoother tracks but show up later while recording.
+    void setTrackingLagMs(double lagMs);
+
+    [[nodiscard]] double trackingLagMs() const;
+
+    // Smoothed wall time to estimate one frame, to compare estimators on the
+    // same track. Negative until the first frame.
+    [[nodiscard]] double averageFrameMicros() const;
+
    private:
+    struct FrameParams {
+        double Fs;
+        double Fds;
+        int J;
+        int64_t trackIndex0;
+        // Index of track sample trackIndex0 in signal.
+        int lead;
+        const std::vector<float>* signal;
+        // Sample j of dsSignal lines up with track sample dsOrigin + j * Fs / Fds.
+        const SampleStore* dsSignal;
+        int64_t dsOrigin;
+        // Delay of the decimation filter, in track samples. Zero for
+        // estimators that only work at the full rate.
+        int latency;
+    };
+
+    // Time, RMS ratio and candidates of the frame starting at track sample
+    // trackIndex0 + is.
+    void evaluateFrame(PitchEstimator& estimator, const FrameParams& params, int is,
+                       PitchFrame& frame) const;
+
+    [[nodiscard]] double rmsRatio(const std::vector<float>& signal, int is, int J) const;
+
+    [[nodiscard]] int64_t downsampledIndex(const FrameParams& params, int is) const;
+
+    // Restart the decimated signal at the given track sample.
+    void restartDownsampledSignal(int64_t origin, double Fs, double Fds);
+
+    // Feed the track samples that arrived since the last update to the
+    // decimation filter, up to analysisEnd.
+    void extendDownsampledSignal(int64_t analysisEnd);
+
+    // Drop the results and decimated samples from before the first sample of
+    // a rolling track.
+    void dropBefore(int64_t firstSample, double Fs);
+
+    // Analyse one stale range again at the current rate and replace its
+    // results, with a tracking lag worth of context frames on each side.
+    void recomputeStaleChunk(double Fs, double Fds, int hop, int64_t firstSample,
+                             int64_t trackSamples);
+
     AppState& appState;
 
     std::mutex m_mutex;
 
+    // Persistent copy of the track at Fds, extended as the track grows. Sample
+    // j of it lines up with track sample m_dsOrigin + j * Fs / Fds.
     Resampler m_dsResampler;
-
-    int m_lastTime;
+    SampleStore m_dsSignal;
+    int64_t m_dsOrigin;
+    int64_t m_dsFedUntil;
+    double m_dsRate;
+    std::vector<float> m_dsChunk;
+
+    PitchEstimatorType m_estimatorType;
+    NccfMethod m_nccfMethod;
+    double m_hopMs;
+    // One estimator per worker.
+    std::vector<std::unique_ptr<PitchEstimator>> m_estimators;
+    // Written under m_mutex, read by the UI without it.
+    std::atomic<double> m_averageFrameMicros;
+    std::vector<PitchFrame> m_frames;
+
+    PitchTracker m_tracker;
+    double m_trackingLagMs;
+    bool m_trackerNeedsReset;
+    std::vector<PitchDecision> m_decisions;
+
+    int64_t m_lastTime;
+    // FrameParams::latency of the frames analysed so far.
+    int m_frameLatency;
     double m_lastSampleRate;
+    int64_t m_lastTrackSamples;
 
-    std::vector<double> m_times;
-    std::vector<double> m_pitches;
+    std::vector<float> m_signal;
 
-    int m_minSilenceRunLength;
-    int m_minVoicingRunLength;
+    // Results from before a sample rate change, redone a chunk per update.
+    StaleRanges m_staleRanges;
+    Resampler m_staleResampler;
+    SampleStore m_staleDsSignal;
+    std::vector<float> m_staleSignal;
+    PitchTracker m_staleTracker;
+    std::vector<double> m_staleTimes;
+    std::vector<double> m_stalePitches;
 
-    struct PitchPoint {
-        double time, pitch;
-    };
-    std::vector<PitchPoint> m_pitchBuffer;
+    // Longest range redone in one update. (secs)
+    static constexpr double staleChunkLength = 2.0;
+
+    // Most new audio analysed in one update per worker, keeps the lock short
+    // when catching up. (secs)
+    static constexpr double maxUpdateDuration = 2.0;
+
+    TimeSeries<double> m_pitches;
+    TimeSeriesSummary m_pitchSummary;
+
+    // Last result of getInterpolatedVoicing(), queries usually move little.
+    int64_t m_voicingCursor;
 
     double F0min;
     double F0max;
@@ -6,6 +6,7 @@
 
 #include "../../memusage.h"
 #include "../../state.h"
+#include "../util/fftw.h"
 
 using namespace reformant;
 
@@ -20,10 +21,15 @@ SpectrogramController::SpectrogramController(AppState& appState)
       m_fftMemoMaxMemory(1024_u64 * 1024_u64 * 256_u64),
       m_fftMemoStartTime(0.0),
       m_fftMemoRowCount(0),
-      m_needSpecUpdate(false) {
+      m_memoSampleRate(0.0),
+      m_needSpecUpdate(false),
+      m_specTimeMin(0.0),
+      m_specTimeMax(0.0),
+      m_specTimePerPixel(0.0) {
 }
 
 SpectrogramController::~SpectrogramController() {
+    std::lock_guard plannerLock(util::fftwPlannerMutex());
     if (m_fftPlan != nullptr) fftwf_destroy_plan(m_fftPlan);
     if (m_fftInput != nullptr) fftwf_free(m_fftInput);
     if (m_fftOutput != nullptr) fftwf_free(m_fftOutput);
@@ -36,9 +42,9 @@ void SpectrogramController::setTime(double time) {
     m_timeSamples = time * appState.audioTrack.sampleRate();
 }
 
-int SpectrogramController::timeSamples() const { return m_timeSamples; }
+int64_t SpectrogramController::timeSamples() const { return m_timeSamples; }
 
-void SpectrogramController::setTimeSamples(int timeSamples) {
+void SpectrogramController::setTimeSamples(int64_t timeSamples) {
     m_timeSamples = timeSamples;
     m_time = timeSamples / appState.audioTrack.sampleRate();
 }
@@ -47,6 +53,7 @@ int SpectrogramController::fftLength() const { return m_fftLength; }
 
 void SpectrogramController::setFftLength(int nfft) {
     std::lock_guard lockGuard(m_fftMutex);
+    std::lock_guard plannerLock(util::fftwPlannerMutex());
 
     if (m_fftPlan != nullptr) fftwf_destroy_plan(m_fftPlan);
     if (m_fftInput != nullptr) fftwf_free(m_fftInput);
@@ -88,12 +95,8 @@ uint64_t SpectrogramController::bytesUsedByMemo() {
 }
 
 void SpectrogramController::updateIfNeeded() {
-    using namespace std::chrono_literals;
-
-    // Just return if we couldn't lock, this isn't important because it's
-    // ran periodically, and it avoids a potential deadlock.
-    const std::unique_lock trackLock(appState.audioTrack.mutex(), 50ms);
-    if (!trackLock.owns_lock()) return;
+    // Appends don't block the lease, only structural changes to the track do.
+    const auto trackLease = appState.audioTrack.lease();
 
     std::lock_guard fftGuard(m_fftMutex);
 
@@ -109,6 +112,38 @@ void SpectrogramController::updateIfNeeded() {
         m_fftMemoStartTime = std::max(0.0, m_specTimeMin - 10.0);
     }
 
+    // Track sample rate.
+    const double sampleRate = appState.audioTrack.sampleRate();
+
+    // The track was resampled. Rebuild the memo, starting around the view if
+    // the whole track won't fit anyway.
+    if (sampleRate != m_memoSampleRate) {
+        m_fftMemo.clear();
+        m_fftMemoRowCount = 0;
+        m_fftMemoStartTime = 0.0;
+        if (m_memoSampleRate > 0 &&
+            appState.audioTrack.duration() > approxMemoCapacityInSeconds()) {
+            m_fftMemoStartTime = std::max(0.0, m_specTimeMin - 10.0);
+        }
+        m_memoSampleRate = sampleRate;
+    }
+
+    // Rolling track: forget the rows from before its first sample. Erasing
+    // moves the rest of the memo, so wait until a quarter of it is stale.
+    const int firstBlock = static_cast<int>(
+        (appState.audioTrack.firstSample() + m_fftStride - 1) / m_fftStride);
+    const int memoStartBlock =
+        static_cast<int>(std::floor(m_fftMemoStartTime * sampleRate / m_fftStride));
+    const int staleRows = firstBlock - memoStartBlock;
+    if (staleRows > 0 && 4 * staleRows >= m_fftMemoRowCount) {
+        const int erasedRows = std::min(staleRows, m_fftMemoRowCount);
+        m_fftMemo.erase(m_fftMemo.begin(),
+                        m_fftMemo.begin() + erasedRows * (m_fftLength / 2));
+        m_fftMemoRowCount -= erasedRows;
+        // Half a block in, so that the start block rounds back exactly.
+        m_fftMemoStartTime = (firstBlock + 0.5) * m_fftStride / sampleRate;
+    }
+
     if (m_needSpecUpdate) {
         updateSpectrogramResults();
         m_needSpecUpdate = false;
@@ -118,18 +153,16 @@ void SpectrogramController::updateIfNeeded() {
     // each representing the spectrum of NFFT-length windows,
     // each spaced 10ms apart, starting from t=0.
 
-    // Track sample rate.
-    const double sampleRate = appState.audioTrack.sampleRate();
-
     // Track length in samples.
-    const int trackSampleCount = appState.audioTrack.sampleCount();
+    const int64_t trackSampleCount = appState.audioTrack.sampleCount();
 
     // Stride size in samples.
     m_fftStride = m_fftLength / 4;
     //m_fftStride = static_cast<int>(std::round(20.0 / 1000.0 * sampleRate));
 
     // How many blocks we're expecting for this given stride.
-    const int numBlocks = (trackSampleCount - m_fftLength) / m_fftStride;
+    const int numBlocks =
+        static_cast<int>((trackSampleCount - m_fftLength) / m_fftStride);
     const int numFreqs = m_fftLength / 2;
 
     m_fftMemoStartBlock = static_cast<int>(std::floor(
@@ -146,17 +179,24 @@ void SpectrogramController::updateIfNeeded() {
         return;
     }
 
-    m_fftMemo.resize(actualNumBlocks * numFreqs);
+    // Don't hold the track lease for too long at once, e.g. after a sample rate
+    // change the whole track needs to be analysed again.
+    const int endBlock = actualNumBlocks - numMissingBlocks +
+                         std::min(numMissingBlocks, maxBlocksPerUpdate);
+
+    m_fftMemo.resize(endBlock * numFreqs);
 
-    m_fftMemoRowCount = actualNumBlocks;
+    m_fftMemoRowCount = endBlock;
 
     // Get the starting slice & index where we need to start.
     int slice = actualNumBlocks - numMissingBlocks;
-    int index = (m_fftMemoStartBlock + slice) * m_fftStride;
+    int64_t index = int64_t(m_fftMemoStartBlock + slice) * m_fftStride;
 
-    for (; slice < actualNumBlocks; ++slice, index += m_fftStride) {
-        // Get the track samples.
-        auto trackSamples = appState.audioTrack.data(index, m_fftLength);
+    for (; slice < endBlock; ++slice, index += m_fftStride) {
+        // Read the track samples straight into the FFT input.
+        const auto view = appState.audioTrack.view(index, m_fftLength);
+        view.copyTo(m_fftInput);
+        std::fill(m_fftInput + view.size(), m_fftInput + m_fftLength, 0.0f);
 
         // Apply windowing.
         const int N = m_fftLength - 1;
@@ -170,11 +210,10 @@ void SpectrogramController::updateIfNeeded() {
             const double wk = a0 - a1 * cos((2 * M_PI * i) / N) +
                               a2 * cos((4 * M_PI * i) / N) - a3 * cos((6 * M_PI * i) / N);
 
-            trackSamples[i] = static_cast<float>(trackSamples[i] * wk);
+            m_fftInput[i] = static_cast<float>(m_fftInput[i] * wk);
         }
 
         // Compute FFT.
-        std::copy(trackSamples.begin(), trackSamples.end(), m_fftInput);
         fftwf_execute(m_fftPlan);
 
         // Compute spectrum from FFT output.
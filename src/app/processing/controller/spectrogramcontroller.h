@@ -3,6 +3,7 @@
 
 #include <fftw3.h>
 
+#include <cstdint>
 #include <mutex>
 #include <vector>
 
@@ -30,9 +31,9 @@ public:
 
     void setTime(double time);
 
-    [[nodiscard]] int timeSamples() const;
+    [[nodiscard]] int64_t timeSamples() const;
 
-    void setTimeSamples(int timeSamples);
+    void setTimeSamples(int64_t timeSamples);
 
     [[nodiscard]] int fftLength() const;
 
@@ -59,7 +60,7 @@ private:
     AppState& appState;
 
     volatile double m_time; // volatile because modified from another thread
-    volatile int m_timeSamples;
+    volatile int64_t m_timeSamples;
 
     std::mutex m_fftMutex;
 
@@ -74,6 +75,10 @@ private:
     double m_fftMemoStartTime;
     int m_fftMemoStartBlock;
     int m_fftMemoRowCount;
+    // Track sample rate the memo was computed at.
+    double m_memoSampleRate;
+
+    static constexpr int maxBlocksPerUpdate = 512;
 
     std::vector<float> m_fftMemo;
 
@@ -27,12 +27,8 @@ void WaveformController::forceClear(bool lock) {
 }
 
 void WaveformController::updateIfNeeded() {
-    using namespace std::chrono_literals;
-
-    // Just return if we couldn't lock, this isn't important because it's
-    // ran periodically, and it avoids a potential deadlock.
-    std::unique_lock trackLock(appState.audioTrack.mutex(), 50ms);
-    if (!trackLock.owns_lock()) return;
+    // Appends don't block the lease, only structural changes to the track do.
+    const auto trackLease = appState.audioTrack.lease();
 
     std::lock_guard lockGuard(m_mutex);
 
@@ -69,22 +65,23 @@ void WaveformController::updateWaveformResults() {
     auto& wave = m_waveResults;
 
     const double sampleRate = appState.audioTrack.sampleRate();
-    const int trackSampleCount = appState.audioTrack.sampleCount();
+    const int64_t firstSample = appState.audioTrack.firstSample();
+    const int64_t trackSampleCount = appState.audioTrack.sampleCount();
 
     const double timeMin = m_waveTimeMin;
     const double timeMax = m_waveTimeMax;
     const double timePerPixel = m_waveTimePerPixel;
 
-    if (trackSampleCount == 0 || timePerPixel == 0) {
+    if (trackSampleCount == firstSample || timePerPixel == 0) {
         resetWaveformResults();
         return;
     }
 
-    const int startIndex = std::clamp(static_cast<int>(timeMin * sampleRate), 0,
-                                      trackSampleCount - 1);
-    const int stopIndex = std::clamp(static_cast<int>(timeMax * sampleRate), 0,
-                                     trackSampleCount - 1);
-    const int rangeSampleCount = stopIndex - startIndex + 1;
+    const int64_t startIndex = std::clamp(static_cast<int64_t>(timeMin * sampleRate),
+                                          firstSample, trackSampleCount - 1);
+    const int64_t stopIndex = std::clamp(static_cast<int64_t>(timeMax * sampleRate),
+                                         firstSample, trackSampleCount - 1);
+    const int64_t rangeSampleCount = stopIndex - startIndex + 1;
 
     const double actualTimeMin = startIndex / sampleRate;
     const double actualTimeMax = stopIndex / sampleRate;
@@ -106,9 +103,9 @@ void WaveformController::updateWaveformResults() {
         wave.timeMax = actualTimeMax;
         wave.timeScale = 1 / sampleRate;
         wave.type = WaveformDataType_Samples;
-        wave.samples.resize(rangeSampleCount);
-        const auto window = appState.audioTrack.data(startIndex, rangeSampleCount);
-        std::ranges::copy(window, wave.samples.begin());
+        const auto window = appState.audioTrack.view(startIndex, rangeSampleCount);
+        wave.samples.resize(window.size());
+        window.copyTo(wave.samples.data());
         return;
     }
 
@@ -120,20 +117,17 @@ void WaveformController::updateWaveformResults() {
     wave.rms1.clear();
     wave.rms2.clear();
 
-    const int roundedStartIndex = (startIndex / windowSize) * windowSize;
+    int64_t roundedStartIndex = (startIndex / windowSize) * windowSize;
+    // Don't round down past the first sample of a rolling track.
+    if (roundedStartIndex < firstSample) roundedStartIndex += windowSize;
 
-    int chunkStartIndex = roundedStartIndex;
+    int64_t chunkStartIndex = roundedStartIndex;
     while (chunkStartIndex < stopIndex && chunkStartIndex + windowSize <
            trackSampleCount) {
-        float min = std::numeric_limits<double>::max();
-        float max = std::numeric_limits<double>::lowest();
-        double sumOfSquares = 0;
-        const auto window = appState.audioTrack.data(chunkStartIndex, windowSize);
-        for (int i = 0; i < windowSize; ++i) {
-            min = std::min(window[i], min);
-            max = std::max(window[i], max);
-            sumOfSquares += window[i] * window[i];
-        }
+        // The summary pyramid answers from the coarsest blocks that fit in the
+        // window, so this costs O(pixels) rather than O(samples).
+        const auto [min, max, sumOfSquares] =
+            appState.audioTrack.waveformStats(chunkStartIndex, windowSize);
 
         const double rms = sqrt(sumOfSquares / windowSize);
 
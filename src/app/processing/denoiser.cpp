@@ -1,5 +1,6 @@
 #include "denoiser.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <limits>
 #include <rnnoise.h>
@@ -8,11 +9,21 @@ using namespace reformant;
 
 struct reformant::DenoiserPrivate {
     DenoiseState* st;
+
+    int frameSize;
+    std::vector<float> frame;
+    int frameFill;
 };
 
+// RNNoise works on the signed 16-bit range.
+static constexpr float sampleScale = std::numeric_limits<int16_t>::max();
+
 Denoiser::Denoiser() {
     _p = new DenoiserPrivate;
     _p->st = rnnoise_create(nullptr);
+    _p->frameSize = rnnoise_get_frame_size();
+    _p->frame.resize(_p->frameSize);
+    _p->frameFill = 0;
 }
 
 Denoiser::~Denoiser() {
@@ -20,24 +31,47 @@ Denoiser::~Denoiser() {
     delete _p;
 }
 
-std::vector<float> Denoiser::process(const std::vector<float>& in) {
-    if (in.size() < rnnoise_get_frame_size()) {
-        throw new DenoiserError("Denoising frame too small");
-    }
+void Denoiser::process(std::vector<float>& out, const float* in, int length) {
+    const int frameSize = _p->frameSize;
+    float* frame = _p->frame.data();
+
+    const int completeFrames = (_p->frameFill + length) / frameSize;
+    size_t outPos = 0;
+    out.resize(completeFrames * frameSize);
 
-    std::vector<float> out(in);
+    while (length > 0) {
+        const int n = std::min(length, frameSize - _p->frameFill);
 
-    // Convert to signed 16-bit range
-    for (float& x : out) x *= std::numeric_limits<int16_t>::max();
+        for (int i = 0; i < n; ++i) {
+            frame[_p->frameFill + i] = in[i] * sampleScale;
+        }
 
-    rnnoise_process_frame(_p->st, out.data(), out.data());
+        _p->frameFill += n;
+        in += n;
+        length -= n;
 
-    // Convert back to [-1,1] range
-    for (float& x : out) x /= std::numeric_limits<int16_t>::max();
+        if (_p->frameFill == frameSize) {
+            float* dst = out.data() + outPos;
+            rnnoise_process_frame(_p->st, dst, frame);
+            for (int i = 0; i < frameSize; ++i) dst[i] /= sampleScale;
 
+            outPos += frameSize;
+            _p->frameFill = 0;
+        }
+    }
+}
+
+std::vector<float> Denoiser::process(const std::vector<float>& in) {
+    std::vector<float> out;
+    process(out, in.data(), static_cast<int>(in.size()));
     return out;
 }
 
+void Denoiser::reset() {
+    rnnoise_init(_p->st, nullptr);
+    _p->frameFill = 0;
+}
+
 DenoiserError::DenoiserError(const char* msg) : msg(msg) {}
 
 const char* DenoiserError::what() const noexcept { return msg; }
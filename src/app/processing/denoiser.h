@@ -13,8 +13,16 @@ class Denoiser final {
     Denoiser();
     virtual ~Denoiser();
 
+    // Streaming: input is queued until a whole frame is available, and every
+    // complete frame is denoised and appended to out. Leftover samples are
+    // carried over to the next call.
+    void process(std::vector<float>& out, const float* in, int length);
+
     std::vector<float> process(const std::vector<float>& in);
 
+    // Drop the queued samples and the model state.
+    void reset();
+
    private:
     DenoiserPrivate* _p;
 };
@@ -0,0 +1,149 @@
+#include "mappedfile.h"
+
+#include <iostream>
+
+using namespace reformant;
+
+#ifdef _WIN32
+
+// ; include order is important
+// clang-format off
+    #include <windows.h>
+// clang-format on
+
+struct reformant::MappedFilePrivate {
+    HANDLE file;
+};
+
+MappedFile::MappedFile(const int64_t blockBytes) : m_blockBytes(blockBytes) {
+    _p = new MappedFilePrivate;
+
+    wchar_t dir[MAX_PATH + 1];
+    wchar_t path[MAX_PATH + 1];
+    if (GetTempPathW(MAX_PATH + 1, dir) == 0 ||
+        GetTempFileNameW(dir, L"rfm", 0, path) == 0) {
+        std::cerr << "MappedFile: failed to create a scratch file name" << std::endl;
+        _p->file = INVALID_HANDLE_VALUE;
+        return;
+    }
+
+    _p->file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                           nullptr);
+    if (_p->file == INVALID_HANDLE_VALUE) {
+        std::cerr << "MappedFile: failed to open scratch file" << std::endl;
+    }
+}
+
+MappedFile::~MappedFile() {
+    for (void* block : m_blocks) UnmapViewOfFile(block);
+    if (_p->file != INVALID_HANDLE_VALUE) CloseHandle(_p->file);
+    delete _p;
+}
+
+bool MappedFile::isValid() const { return _p->file != INVALID_HANDLE_VALUE; }
+
+void* MappedFile::mapBlock() {
+    if (!isValid()) return nullptr;
+
+    const uint64_t offset = static_cast<uint64_t>(m_blocks.size()) * m_blockBytes;
+    const uint64_t end = offset + m_blockBytes;
+
+    // The mapping object extends the file to its maximum size.
+    HANDLE mapping = CreateFileMappingW(_p->file, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(end >> 32),
+                                        static_cast<DWORD>(end), nullptr);
+    if (mapping == nullptr) {
+        std::cerr << "MappedFile: CreateFileMapping failed" << std::endl;
+        return nullptr;
+    }
+
+    void* block = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS,
+                                static_cast<DWORD>(offset >> 32),
+                                static_cast<DWORD>(offset), m_blockBytes);
+    // The view keeps its own reference to the mapping object.
+    CloseHandle(mapping);
+
+    if (block == nullptr) {
+        std::cerr << "MappedFile: MapViewOfFile failed" << std::endl;
+        return nullptr;
+    }
+
+    m_blocks.push_back(block);
+    return block;
+}
+
+void MappedFile::evict(void* block) {
+    // Unlocking pages that aren't locked removes them from the working set.
+    VirtualUnlock(block, m_blockBytes);
+}
+
+#else  // POSIX
+
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+
+    #include <cstdlib>
+    #include <filesystem>
+    #include <string>
+
+struct reformant::MappedFilePrivate {
+    int fd;
+};
+
+MappedFile::MappedFile(const int64_t blockBytes) : m_blockBytes(blockBytes) {
+    _p = new MappedFilePrivate;
+
+    std::string path =
+        (std::filesystem::temp_directory_path() / "reformant-XXXXXX").string();
+    _p->fd = mkstemp(path.data());
+    if (_p->fd < 0) {
+        std::cerr << "MappedFile: failed to open scratch file" << std::endl;
+        return;
+    }
+
+    // Unlink right away so the file disappears with the process.
+    unlink(path.c_str());
+}
+
+MappedFile::~MappedFile() {
+    for (void* block : m_blocks) munmap(block, m_blockBytes);
+    if (_p->fd >= 0) close(_p->fd);
+    delete _p;
+}
+
+bool MappedFile::isValid() const { return _p->fd >= 0; }
+
+void* MappedFile::mapBlock() {
+    if (!isValid()) return nullptr;
+
+    const off_t offset = static_cast<off_t>(m_blocks.size()) * m_blockBytes;
+
+    if (ftruncate(_p->fd, offset + m_blockBytes) != 0) {
+        std::cerr << "MappedFile: failed to grow scratch file" << std::endl;
+        return nullptr;
+    }
+
+    void* block =
+        mmap(nullptr, m_blockBytes, PROT_READ | PROT_WRITE, MAP_SHARED, _p->fd, offset);
+    if (block == MAP_FAILED) {
+        std::cerr << "MappedFile: mmap failed" << std::endl;
+        return nullptr;
+    }
+
+    m_blocks.push_back(block);
+    return block;
+}
+
+void MappedFile::evict(void* block) {
+    // Start writeback, then drop the pages from this process. For a shared
+    // file mapping the contents are kept and faulted back in on access.
+    msync(block, m_blockBytes, MS_ASYNC);
+    madvise(block, m_blockBytes, MADV_DONTNEED);
+}
+
+#endif
+
+int MappedFile::blockCount() const { return static_cast<int>(m_blocks.size()); }
@@ -0,0 +1,41 @@
+#ifndef REFORMANT_PROCESSING_MAPPEDFILE_H
+#define REFORMANT_PROCESSING_MAPPEDFILE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace reformant {
+
+struct MappedFilePrivate;
+
+// Anonymous scratch file in the temp directory, mapped into memory in
+// fixed-size blocks. The file is deleted when it's closed.
+class MappedFile final {
+   public:
+    explicit MappedFile(int64_t blockBytes);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] bool isValid() const;
+
+    // Grow the file by one block and map it. Returns nullptr on failure.
+    void* mapBlock();
+
+    // Drop a block from the resident set. Its contents stay in the file and
+    // are paged back in on the next access.
+    void evict(void* block);
+
+    [[nodiscard]] int blockCount() const;
+
+   private:
+    int64_t m_blockBytes;
+    std::vector<void*> m_blocks;
+
+    MappedFilePrivate* _p;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_MAPPEDFILE_H
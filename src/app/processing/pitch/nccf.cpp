@@ -0,0 +1,184 @@
+#include "nccf.h"
+
+#include <fftw3.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "../util/fftw.h"
+#include "../util/simd.h"
+
+using namespace reformant;
+
+struct reformant::NccfEnginePrivate {
+    int fftLength = 0;
+    float* time = nullptr;
+    fftwf_complex* windowSpectrum = nullptr;
+    fftwf_complex* signalSpectrum = nullptr;
+    fftwf_plan forward = nullptr;
+    fftwf_plan inverse = nullptr;
+
+    void destroy() {
+        std::lock_guard plannerLock(util::fftwPlannerMutex());
+        if (forward != nullptr) fftwf_destroy_plan(forward);
+        if (inverse != nullptr) fftwf_destroy_plan(inverse);
+        if (time != nullptr) fftwf_free(time);
+        if (windowSpectrum != nullptr) fftwf_free(windowSpectrum);
+        if (signalSpectrum != nullptr) fftwf_free(signalSpectrum);
+        forward = inverse = nullptr;
+        time = nullptr;
+        windowSpectrum = signalSpectrum = nullptr;
+        fftLength = 0;
+    }
+
+    // Grow the plans to at least the given length. Sizes only change with the
+    // sample rate, so in practice this plans once.
+    void reserve(const int length) {
+        if (length <= fftLength) return;
+
+        destroy();
+
+        int nfft = 1;
+        while (nfft < length) nfft <<= 1;
+
+        std::lock_guard plannerLock(util::fftwPlannerMutex());
+        fftLength = nfft;
+        time = fftwf_alloc_real(nfft);
+        windowSpectrum = fftwf_alloc_complex(nfft / 2 + 1);
+        signalSpectrum = fftwf_alloc_complex(nfft / 2 + 1);
+        forward = fftwf_plan_dft_r2c_1d(nfft, time, signalSpectrum, FFTW_MEASURE);
+        inverse = fftwf_plan_dft_c2r_1d(nfft, signalSpectrum, time, FFTW_MEASURE);
+    }
+};
+
+NccfEngine::NccfEngine(const NccfMethod method) : m_method(method) {
+    _p = new NccfEnginePrivate;
+}
+
+NccfEngine::~NccfEngine() {
+    _p->destroy();
+    delete _p;
+}
+
+void NccfEngine::setMethod(const NccfMethod method) { m_method = method; }
+
+NccfMethod NccfEngine::method() const { return m_method; }
+
+void NccfEngine::compute(const float* x, const int n, const int k1, const int k2,
+                         std::vector<double>& nccf) {
+    updateEnergies(x, n + k2);
+
+    std::fill(nccf.begin(), nccf.begin() + k1, 0.0);
+
+    if (m_method == NccfMethod_Fft) {
+        correlateFft(x, n, k2);
+        for (int k = k1; k <= k2; ++k) {
+            nccf[k] = normalize(m_correlation[k], n, k);
+        }
+    } else {
+        for (int k = k1; k <= k2; ++k) {
+            nccf[k] = normalize(correlateDirect(x, n, k), n, k);
+        }
+    }
+}
+
+void NccfEngine::computeLags(const float* x, const int n, const std::vector<int>& lags,
+                             std::vector<double>& nccf) {
+    std::fill(nccf.begin(), nccf.end(), 0.0);
+
+    if (lags.empty()) return;
+
+    const int maxLag = lags.back();
+    updateEnergies(x, n + maxLag);
+
+    if (m_method == NccfMethod_Fft) {
+        correlateFft(x, n, maxLag);
+        for (const int k : lags) {
+            nccf[k] = normalize(m_correlation[k], n, k);
+        }
+    } else {
+        for (const int k : lags) {
+            nccf[k] = normalize(correlateDirect(x, n, k), n, k);
+        }
+    }
+}
+
+void NccfEngine::computeDifference(const float* x, const int n, const int maxLag,
+                                   std::vector<double>& difference) {
+    updateEnergies(x, n + maxLag);
+
+    difference.resize(maxLag + 1);
+
+    if (m_method == NccfMethod_Fft) {
+        correlateFft(x, n, maxLag);
+    } else {
+        m_correlation.resize(maxLag + 1);
+        for (int k = 0; k <= maxLag; ++k) {
+            m_correlation[k] = correlateDirect(x, n, k);
+        }
+    }
+
+    const double e0 = m_energies[n];
+    for (int k = 0; k <= maxLag; ++k) {
+        const double ek = m_energies[k + n] - m_energies[k];
+        difference[k] = std::max(e0 + ek - 2 * m_correlation[k], 0.0);
+    }
+}
+
+void NccfEngine::updateEnergies(const float* x, const int length) {
+    // Running sum, so that the energy of x[k, k + n) is one subtraction away
+    // for every lag instead of a fresh O(n) loop.
+    m_energies.resize(length + 1);
+    m_energies[0] = 0;
+    for (int i = 0; i < length; ++i) {
+        m_energies[i + 1] = m_energies[i] + double(x[i]) * x[i];
+    }
+}
+
+void NccfEngine::correlateFft(const float* x, const int n, const int maxLag) {
+    // The window is zero-padded, so as long as the FFT covers n + maxLag
+    // samples the circular correlation doesn't wrap for lags up to maxLag.
+    const int length = n + maxLag;
+    _p->reserve(length);
+
+    const int nfft = _p->fftLength;
+    const int nbins = nfft / 2 + 1;
+    float* time = _p->time;
+
+    std::copy_n(x, n, time);
+    std::fill(time + n, time + nfft, 0.0f);
+    fftwf_execute_dft_r2c(_p->forward, time, _p->windowSpectrum);
+
+    std::copy_n(x, length, time);
+    std::fill(time + length, time + nfft, 0.0f);
+    fftwf_execute_dft_r2c(_p->forward, time, _p->signalSpectrum);
+
+    // conj(W) * S
+    fftwf_complex* w = _p->windowSpectrum;
+    fftwf_complex* s = _p->signalSpectrum;
+    for (int i = 0; i < nbins; ++i) {
+        const float re = w[i][0] * s[i][0] + w[i][1] * s[i][1];
+        const float im = w[i][0] * s[i][1] - w[i][1] * s[i][0];
+        s[i][0] = re;
+        s[i][1] = im;
+    }
+
+    fftwf_execute_dft_c2r(_p->inverse, s, time);
+
+    // FFTW doesn't normalize the inverse transform.
+    m_correlation.resize(maxLag + 1);
+    for (int k = 0; k <= maxLag; ++k) {
+        m_correlation[k] = double(time[k]) / nfft;
+    }
+}
+
+double NccfEngine::correlateDirect(const float* x, const int n, const int k) const {
+    return util::dotProduct(x, x + k, n);
+}
+
+double NccfEngine::normalize(const double p, const int n, const int k) const {
+    const double e0 = m_energies[n];
+    // Rounding in the prefix sums can leave a tiny negative energy.
+    const double ek = std::max(m_energies[k + n] - m_energies[k], 0.0);
+    return p / sqrt(e0 * ek);
+}
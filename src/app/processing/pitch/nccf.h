@@ -0,0 +1,67 @@
+#ifndef REFORMANT_PROCESSING_PITCH_NCCF_H
+#define REFORMANT_PROCESSING_PITCH_NCCF_H
+
+#include <vector>
+
+namespace reformant {
+
+enum NccfMethod {
+    // One dot product per lag.
+    NccfMethod_Direct,
+    // Correlation for all lags at once through FFTW.
+    NccfMethod_Fft,
+};
+
+struct NccfEnginePrivate;
+
+// Normalized cross-correlation of a window x[0, n) against x[k, k + n).
+// Lag energies come from prefix sums, so they cost O(1) per lag either way.
+// Buffers and FFT plans are kept from one call to the next, an engine must
+// not be shared between threads.
+class NccfEngine final {
+   public:
+    explicit NccfEngine(NccfMethod method = NccfMethod_Fft);
+    ~NccfEngine();
+
+    NccfEngine(const NccfEngine&) = delete;
+    NccfEngine& operator=(const NccfEngine&) = delete;
+
+    void setMethod(NccfMethod method);
+    [[nodiscard]] NccfMethod method() const;
+
+    // nccf[k] for k1 <= k <= k2, zero below k1. x must hold n + k2 samples.
+    void compute(const float* x, int n, int k1, int k2, std::vector<double>& nccf);
+
+    // nccf[k] only for the given lags, zero elsewhere. Lags must be sorted and
+    // below nccf.size(), and x must hold n + nccf.size() - 1 samples.
+    void computeLags(const float* x, int n, const std::vector<int>& lags,
+                     std::vector<double>& nccf);
+
+    // Squared difference sum((x[j] - x[j + k])^2, 0 <= j < n) for 0 <= k <= maxLag,
+    // as used by YIN. It expands to the same energies and correlation terms.
+    // x must hold n + maxLag samples.
+    void computeDifference(const float* x, int n, int maxLag,
+                           std::vector<double>& difference);
+
+   private:
+    void updateEnergies(const float* x, int length);
+
+    void correlateFft(const float* x, int n, int maxLag);
+
+    [[nodiscard]] double correlateDirect(const float* x, int n, int k) const;
+
+    [[nodiscard]] double normalize(double p, int n, int k) const;
+
+    NccfMethod m_method;
+
+    // Prefix sums of x^2.
+    std::vector<double> m_energies;
+    // Raw correlation by lag, from the FFT path.
+    std::vector<double> m_correlation;
+
+    NccfEnginePrivate* _p;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_PITCH_NCCF_H
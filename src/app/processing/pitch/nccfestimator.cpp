@@ -0,0 +1,122 @@
+#include "nccfestimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../samplestore.h"
+#include "../util/util.h"
+
+using namespace reformant;
+
+namespace {
+std::vector<std::pair<double, double> > findPeaksWithThreshold(
+    const std::vector<double>& nccf, double cand_tr, int n_cands, bool paraInterp);
+}  // namespace
+
+NccfEstimator::NccfEstimator(const NccfMethod method)
+    : m_params{}, n(0), K(0), dsn(0), dsK1(0), dsK2(0), dswl(0), m_nccf(method) {}
+
+void NccfEstimator::configure(const PitchEstimatorParams& params) {
+    m_params = params;
+
+    const auto& [Fs, Fds, F0min, F0max, cand_tr, n_cands] = params;
+
+    n = static_cast<int>(std::round(w * Fs));
+    K = static_cast<int>(std::round(Fs / F0min));
+
+    dsn = static_cast<int>(std::round(w * Fds));
+    dsK1 = static_cast<int>(std::round(Fds / F0max));
+    dsK2 = static_cast<int>(std::round(Fds / F0min));
+    dswl = dsn + dsK2;
+}
+
+int NccfEstimator::windowLength() const { return n + K; }
+
+int NccfEstimator::decimatedWindowLength() const { return dswl; }
+
+void NccfEstimator::estimate(const PitchFrameInput& input, PitchFrame& frame) {
+    const auto& [Fs, Fds, F0min, F0max, cand_tr, n_cands] = m_params;
+
+    frame.maxCorrelation = 0;
+    frame.candidates.clear();
+
+    m_dsNCCF.resize(dsK2 + 1);
+    m_nccfValues.resize(K + 1);
+
+    // Frames index into the decimated signal instead of filtering their own
+    // samples again.
+    m_dsFrame.resize(dswl);
+    input.dsSignal->copy(input.dsIndex, dswl, m_dsFrame.data());
+    util::subtractMean(m_dsFrame);
+
+    m_nccf.compute(m_dsFrame.data(), dsn, dsK1, dsK2, m_dsNCCF);
+    const auto dsPeaks = findPeaksWithThreshold(m_dsNCCF, cand_tr, n_cands, false);
+
+    if (dsPeaks.empty()) {
+        return;
+    }
+
+    selectLags(dsPeaks);
+    m_nccf.computeLags(input.signal, n, m_lags, m_nccfValues);
+
+    for (const auto& [k, y] :
+         findPeaksWithThreshold(m_nccfValues, cand_tr, n_cands, false)) {
+        frame.candidates.push_back(PitchCandidate{k, y});
+        frame.maxCorrelation = std::max(frame.maxCorrelation, y);
+    }
+}
+
+void NccfEstimator::selectLags(const std::vector<std::pair<double, double>>& dsPeaks) {
+    const auto& [Fs, Fds, F0min, F0max, cand_tr, n_cands] = m_params;
+
+    m_lags.clear();
+
+    for (const auto& [dsk, y] : dsPeaks) {
+        const int k = static_cast<int>(std::round((Fs * dsk) / Fds));
+
+        if (k >= 0 && k <= K) m_lags.push_back(k);
+
+        for (int l = 1; l <= 3; ++l) {
+            if (k - l >= 0 && k - l <= K) m_lags.push_back(k - l);
+            if (k + l >= 0 && k + l <= K) m_lags.push_back(k + l);
+        }
+    }
+
+    std::sort(m_lags.begin(), m_lags.end());
+    m_lags.erase(std::unique(m_lags.begin(), m_lags.end()), m_lags.end());
+}
+
+namespace {
+std::vector<std::pair<double, double> > findPeaksWithThreshold(
+    const std::vector<double>& nccf, const double cand_tr, const int n_cands,
+    const bool paraInterp) {
+    double max = std::numeric_limits<double>::lowest();
+    for (int i = 0; i < nccf.size(); ++i) {
+        if (nccf[i] > max) {
+            max = nccf[i];
+        }
+    }
+
+    const double threshold = cand_tr * max;
+
+    auto allPeaks = util::findPeaks(nccf);
+
+    std::vector<std::pair<double, double> > peaks;
+
+    for (const int k : allPeaks) {
+        if (k >= 0 && k < nccf.size() && nccf[k] > threshold) {
+            peaks.push_back(util::parabolicInterpolation(nccf, k));
+        }
+    }
+
+    std::sort(peaks.begin(), peaks.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+
+    if (peaks.size() > n_cands - 1) {
+        peaks.erase(std::next(peaks.begin(), n_cands - 1), peaks.end());
+    }
+
+    return peaks;
+}
+}  // namespace
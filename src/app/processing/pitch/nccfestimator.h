@@ -0,0 +1,51 @@
+#ifndef REFORMANT_PROCESSING_PITCH_NCCFESTIMATOR_H
+#define REFORMANT_PROCESSING_PITCH_NCCFESTIMATOR_H
+
+#include <utility>
+#include <vector>
+
+#include "nccf.h"
+#include "pitchestimator.h"
+
+namespace reformant {
+
+// First pass of RAPT: NCCF peaks on the decimated signal, then the NCCF at the
+// full rate only around those peaks.
+class NccfEstimator final : public PitchEstimator {
+   public:
+    explicit NccfEstimator(NccfMethod method);
+
+    void configure(const PitchEstimatorParams& params) override;
+
+    [[nodiscard]] int windowLength() const override;
+
+    [[nodiscard]] int decimatedWindowLength() const override;
+
+    void estimate(const PitchFrameInput& input, PitchFrame& frame) override;
+
+   private:
+    // Lags at the full rate around the decimated peaks.
+    void selectLags(const std::vector<std::pair<double, double>>& dsPeaks);
+
+    PitchEstimatorParams m_params;
+
+    // Correlation window size. (secs)
+    static constexpr double w = 0.0075;
+
+    int n;
+    int K;
+    int dsn;
+    int dsK1;
+    int dsK2;
+    int dswl;
+
+    NccfEngine m_nccf;
+    std::vector<float> m_dsFrame;
+    std::vector<double> m_dsNCCF;
+    std::vector<double> m_nccfValues;
+    std::vector<int> m_lags;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_PITCH_NCCFESTIMATOR_H
@@ -0,0 +1,17 @@
+#include "pitchestimator.h"
+
+#include "nccfestimator.h"
+#include "yinestimator.h"
+
+using namespace reformant;
+
+std::unique_ptr<PitchEstimator> reformant::makePitchEstimator(
+    const PitchEstimatorType type, const NccfMethod nccfMethod) {
+    switch (type) {
+        case PitchEstimator_Yin:
+            return std::make_unique<YinEstimator>(nccfMethod);
+        case PitchEstimator_Nccf:
+        default:
+            return std::make_unique<NccfEstimator>(nccfMethod);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef REFORMANT_PROCESSING_PITCH_PITCHESTIMATOR_H
+#define REFORMANT_PROCESSING_PITCH_PITCHESTIMATOR_H
+
+#include <cstdint>
+#include <memory>
+
+#include "nccf.h"
+#include "pitchtracker.h"
+
+namespace reformant {
+
+class SampleStore;
+
+enum PitchEstimatorType {
+    // RAPT: NCCF on a decimated signal, refined at the full rate.
+    PitchEstimator_Nccf,
+    // YIN: cumulative mean normalized difference at the full rate.
+    PitchEstimator_Yin,
+};
+
+struct PitchEstimatorParams {
+    // Track and decimated sample rates.
+    double Fs;
+    double Fds;
+    double F0min;
+    double F0max;
+    // Candidate threshold, relative to the best one.
+    double cand_tr;
+    // At most n_cands - 1 voiced candidates per frame.
+    int n_cands;
+};
+
+// Where a frame reads its samples from.
+struct PitchFrameInput {
+    // Frame start in the track, with windowLength() samples after it.
+    const float* signal;
+    // Decimated copy of the track and the frame start in it, with
+    // decimatedWindowLength() samples after it.
+    const SampleStore* dsSignal;
+    int64_t dsIndex;
+};
+
+// Pitch candidates for one analysis frame at a time.
+// Estimators keep scratch buffers and FFT plans, so each worker thread needs
+// its own instance.
+class PitchEstimator {
+   public:
+    virtual ~PitchEstimator() = default;
+
+    virtual void configure(const PitchEstimatorParams& params) = 0;
+
+    // Track samples a frame reads from its start.
+    [[nodiscard]] virtual int windowLength() const = 0;
+
+    // Decimated samples a frame reads from its start, 0 if it doesn't use them.
+    [[nodiscard]] virtual int decimatedWindowLength() const = 0;
+
+    // Fill the candidates and maxCorrelation of frame. Candidates are scored
+    // like NCCF peaks, between 0 and 1, so that the tracker can take either.
+    virtual void estimate(const PitchFrameInput& input, PitchFrame& frame) = 0;
+};
+
+std::unique_ptr<PitchEstimator> makePitchEstimator(PitchEstimatorType type,
+                                                   NccfMethod nccfMethod);
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_PITCH_PITCHESTIMATOR_H
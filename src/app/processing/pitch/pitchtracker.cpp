@@ -0,0 +1,167 @@
+#include "pitchtracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace reformant;
+
+PitchTracker::PitchTracker()
+    : m_costs{}, m_lagFrames(0), m_maxCandidates(0), m_head(0), m_count(0) {}
+
+void PitchTracker::reset(const int lagFrames, const int maxCandidates) {
+    m_lagFrames = std::max(lagFrames, 0);
+    m_maxCandidates = std::max(maxCandidates, 0);
+
+    m_columns.resize(m_lagFrames + 1);
+    for (auto& column : m_columns) {
+        column.count = 0;
+        column.pitches.resize(m_maxCandidates + 1);
+        column.cumulativeCosts.resize(m_maxCandidates + 1);
+        column.backPointers.resize(m_maxCandidates + 1);
+    }
+
+    clear();
+}
+
+void PitchTracker::clear() {
+    m_head = 0;
+    m_count = 0;
+}
+
+void PitchTracker::setCosts(const PitchTrackerCosts& costs) { m_costs = costs; }
+
+int PitchTracker::lagFrames() const { return m_lagFrames; }
+
+int PitchTracker::pendingFrames() const { return m_count; }
+
+bool PitchTracker::push(const PitchFrame& frame, PitchDecision& decision) {
+    if (m_columns.empty()) return false;
+
+    const double beta = m_costs.lag_wt / (m_costs.sampleRate / m_costs.F0min);
+
+    // With a full lattice the slot of the oldest column is reused, decide it
+    // before it gets overwritten.
+    bool decided = false;
+    if (m_count == m_columns.size()) {
+        const Column& oldest = column(0);
+        const int state = traceBack(bestState(column(m_count - 1)), 0);
+        decision = PitchDecision{oldest.time, oldest.pitches[state]};
+        decided = true;
+
+        m_head = (m_head + 1) % m_columns.size();
+        --m_count;
+    }
+
+    const Column* previous = (m_count > 0) ? &column(m_count - 1) : nullptr;
+
+    ++m_count;
+    Column& current = column(m_count - 1);
+
+    const int voicedCount =
+        std::min(static_cast<int>(frame.candidates.size()), m_maxCandidates);
+
+    current.time = frame.time;
+    current.count = voicedCount + 1;
+
+    for (int j = 0; j < current.count; ++j) {
+        double localCost;
+        if (j == 0) {
+            current.pitches[j] = -1;
+            localCost = m_costs.vo_bias + frame.maxCorrelation;
+        } else {
+            const auto& [lag, correlation] = frame.candidates[j - 1];
+            current.pitches[j] = m_costs.sampleRate / lag;
+            localCost = 1 - correlation * (1 - beta * lag);
+        }
+
+        if (previous == nullptr) {
+            current.cumulativeCosts[j] = localCost;
+            current.backPointers[j] = -1;
+            continue;
+        }
+
+        double minCost = std::numeric_limits<double>::max();
+        int minState = 0;
+        for (int k = 0; k < previous->count; ++k) {
+            const double cost =
+                previous->cumulativeCosts[k] +
+                transitionCost(previous->pitches[k], current.pitches[j], frame.rmsRatio);
+            if (cost < minCost) {
+                minCost = cost;
+                minState = k;
+            }
+        }
+
+        current.cumulativeCosts[j] = minCost + localCost;
+        current.backPointers[j] = minState;
+    }
+
+    // Only differences between states matter, keep the sums from growing.
+    const double minCumulative = *std::min_element(
+        current.cumulativeCosts.begin(), current.cumulativeCosts.begin() + current.count);
+    for (int j = 0; j < current.count; ++j) {
+        current.cumulativeCosts[j] -= minCumulative;
+    }
+
+    return decided;
+}
+
+void PitchTracker::flush(std::vector<PitchDecision>& decisions) {
+    if (m_count == 0) return;
+
+    const size_t first = decisions.size();
+    decisions.resize(first + m_count);
+
+    int state = bestState(column(m_count - 1));
+    for (int i = m_count - 1; i >= 0; --i) {
+        const Column& c = column(i);
+        decisions[first + i] = PitchDecision{c.time, c.pitches[state]};
+        if (i > 0) state = c.backPointers[state];
+    }
+
+    clear();
+}
+
+double PitchTracker::transitionCost(const double fromPitch, const double toPitch,
+                                    const double rmsRatio) const {
+    const bool fromVoiced = fromPitch > 0;
+    const bool toVoiced = toPitch > 0;
+
+    if (!fromVoiced && !toVoiced) {
+        return 0;
+    }
+
+    if (fromVoiced && toVoiced) {
+        // Octave jumps cost doubl_c on top of the remaining distance, so that
+        // doubling and halving stay possible but aren't free.
+        const double r = std::log(toPitch / fromPitch);
+        const double distance =
+            std::min({std::abs(r), m_costs.doubl_c + std::abs(r - M_LN2),
+                      m_costs.doubl_c + std::abs(r + M_LN2)});
+        return m_costs.freq_wt * distance;
+    }
+
+    // Voicing onsets are cheap when the energy rises, offsets when it falls.
+    // The spectral stationarity factor of RAPT is taken as 1.
+    const double amplitudeTerm = toVoiced ? 1 / rmsRatio : rmsRatio;
+    return m_costs.vtran_c + m_costs.vtr_s_c + m_costs.vtr_a_c * amplitudeTerm;
+}
+
+PitchTracker::Column& PitchTracker::column(const int index) {
+    return m_columns[(m_head + index) % m_columns.size()];
+}
+
+int PitchTracker::bestState(const Column& column) const {
+    return static_cast<int>(
+        std::min_element(column.cumulativeCosts.begin(),
+                         column.cumulativeCosts.begin() + column.count) -
+        column.cumulativeCosts.begin());
+}
+
+int PitchTracker::traceBack(int state, const int index) {
+    for (int i = m_count - 1; i > index; --i) {
+        state = column(i).backPointers[state];
+    }
+    return state;
+}
@@ -0,0 +1,106 @@
+#ifndef REFORMANT_PROCESSING_PITCH_PITCHTRACKER_H
+#define REFORMANT_PROCESSING_PITCH_PITCHTRACKER_H
+
+#include <vector>
+
+namespace reformant {
+
+struct PitchCandidate {
+    // Correlation lag in samples, may be fractional.
+    double lag;
+    // Normalized cross-correlation at that lag.
+    double correlation;
+};
+
+// Everything the tracker needs to know about one analysis frame.
+struct PitchFrame {
+    double time;
+    // RMS after the frame over RMS before it, for the voicing transition cost.
+    double rmsRatio;
+    // Largest NCCF peak, sets the cost of the unvoiced hypothesis.
+    double maxCorrelation;
+    std::vector<PitchCandidate> candidates;
+};
+
+struct PitchDecision {
+    double time;
+    // -1 if unvoiced.
+    double pitch;
+};
+
+// RAPT cost weights, see D. Talkin, "A Robust Algorithm for Pitch Tracking".
+struct PitchTrackerCosts {
+    double sampleRate;
+    double F0min;
+    double lag_wt;
+    double freq_wt;
+    double vtran_c;
+    double vtr_a_c;
+    double vtr_s_c;
+    double vo_bias;
+    double doubl_c;
+};
+
+// Streaming dynamic-programming pitch tracker with a fixed decision lag.
+// The lattice only holds the last lagFrames + 1 frames, in a ring of columns
+// allocated once by reset(). Each pushed frame extends the best paths, and the
+// oldest frame is decided by tracing back from the best current state, so a
+// decision comes out lagFrames frames after its frame went in.
+class PitchTracker final {
+   public:
+    PitchTracker();
+
+    // Empty the lattice and size it for the given lag and number of voiced
+    // candidates per frame. Extra candidates are ignored.
+    void reset(int lagFrames, int maxCandidates);
+
+    // Drop pending frames, keep the sizes.
+    void clear();
+
+    void setCosts(const PitchTrackerCosts& costs);
+
+    [[nodiscard]] int lagFrames() const;
+    [[nodiscard]] int pendingFrames() const;
+
+    // Add the next frame. Returns true if the oldest pending frame was decided.
+    bool push(const PitchFrame& frame, PitchDecision& decision);
+
+    // Decide all pending frames from the best current state and empty the
+    // lattice. Decisions are appended in time order.
+    void flush(std::vector<PitchDecision>& decisions);
+
+   private:
+    struct Column {
+        double time;
+        int count;
+        // Index 0 is the unvoiced state, pitch -1.
+        std::vector<double> pitches;
+        std::vector<double> cumulativeCosts;
+        std::vector<int> backPointers;
+    };
+
+    [[nodiscard]] double transitionCost(double fromPitch, double toPitch,
+                                        double rmsRatio) const;
+
+    // Pending column by index, 0 is the oldest.
+    [[nodiscard]] Column& column(int index);
+
+    [[nodiscard]] int bestState(const Column& column) const;
+
+    // State of the column at index on the best path to the given state of the
+    // newest column.
+    [[nodiscard]] int traceBack(int state, int index);
+
+    PitchTrackerCosts m_costs;
+
+    int m_lagFrames;
+    int m_maxCandidates;
+
+    std::vector<Column> m_columns;
+    int m_head;
+    int m_count;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_PITCH_PITCHTRACKER_H
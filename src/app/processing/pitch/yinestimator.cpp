@@ -0,0 +1,73 @@
+#include "yinestimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace reformant;
+
+YinEstimator::YinEstimator(const NccfMethod method)
+    : m_params{}, W(0), K1(0), K(0), m_engine(method) {}
+
+void YinEstimator::configure(const PitchEstimatorParams& params) {
+    m_params = params;
+
+    K = static_cast<int>(std::round(params.Fs / params.F0min));
+    K1 = std::max(static_cast<int>(std::round(params.Fs / params.F0max)), 1);
+    W = K;
+}
+
+int YinEstimator::windowLength() const { return W + K; }
+
+int YinEstimator::decimatedWindowLength() const { return 0; }
+
+void YinEstimator::estimate(const PitchFrameInput& input, PitchFrame& frame) {
+    frame.maxCorrelation = 0;
+    frame.candidates.clear();
+
+    m_engine.computeDifference(input.signal, W, K, m_difference);
+
+    // Cumulative mean normalized difference, d'(0) = 1.
+    auto& d = m_cmnd;
+    d.resize(K + 1);
+    d[0] = 1;
+    double runningSum = 0;
+    for (int k = 1; k <= K; ++k) {
+        runningSum += m_difference[k];
+        d[k] = (runningSum > 0) ? m_difference[k] * k / runningSum : 1;
+    }
+
+    for (int k = K1; k < K; ++k) {
+        if (d[k] >= threshold || d[k] >= d[k - 1] || d[k] > d[k + 1]) continue;
+
+        // Parabolic interpolation of the dip.
+        const double den = d[k + 1] + d[k - 1] - 2 * d[k];
+        const double delta = d[k - 1] - d[k + 1];
+        const double shift = (den > 0) ? delta / (2 * den) : 0;
+        const double value = (den > 0) ? d[k] - delta * delta / (8 * den) : d[k];
+
+        // Score dips like NCCF peaks so the RAPT costs apply as they are.
+        const double score = std::clamp(1 - value, 0.0, 1.0);
+        frame.candidates.push_back(PitchCandidate{k + shift, score});
+    }
+
+    if (frame.candidates.empty()) {
+        return;
+    }
+
+    auto& candidates = frame.candidates;
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a.correlation > b.correlation; });
+
+    frame.maxCorrelation = candidates.front().correlation;
+
+    // Same pruning as the NCCF candidates.
+    const double cutoff = m_params.cand_tr * frame.maxCorrelation;
+    const auto last =
+        std::find_if(candidates.begin(), candidates.end(),
+                     [cutoff](const auto& c) { return c.correlation <= cutoff; });
+    candidates.erase(last, candidates.end());
+
+    if (candidates.size() > m_params.n_cands - 1) {
+        candidates.resize(m_params.n_cands - 1);
+    }
+}
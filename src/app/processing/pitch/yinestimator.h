@@ -0,0 +1,47 @@
+#ifndef REFORMANT_PROCESSING_PITCH_YINESTIMATOR_H
+#define REFORMANT_PROCESSING_PITCH_YINESTIMATOR_H
+
+#include <vector>
+
+#include "nccf.h"
+#include "pitchestimator.h"
+
+namespace reformant {
+
+// YIN, see A. de Cheveigné and H. Kawahara, "YIN, a fundamental frequency
+// estimator for speech and music". Every dip of the cumulative mean normalized
+// difference below a loose threshold becomes a candidate, in the spirit of
+// pYIN, and the tracker picks among them. The difference function comes from
+// the NCCF engine's energy and correlation kernels.
+class YinEstimator final : public PitchEstimator {
+   public:
+    // Dips above this are not considered periodic at all.
+    static constexpr double threshold = 0.6;
+
+    explicit YinEstimator(NccfMethod method);
+
+    void configure(const PitchEstimatorParams& params) override;
+
+    [[nodiscard]] int windowLength() const override;
+
+    [[nodiscard]] int decimatedWindowLength() const override;
+
+    void estimate(const PitchFrameInput& input, PitchFrame& frame) override;
+
+   private:
+    PitchEstimatorParams m_params;
+
+    // Integration window, one period of F0min.
+    int W;
+    // Lag range.
+    int K1;
+    int K;
+
+    NccfEngine m_engine;
+    std::vector<double> m_difference;
+    std::vector<double> m_cmnd;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_PITCH_YINESTIMATOR_H
@@ -94,6 +94,12 @@ void Resampler::process(std::vector<float>& out, const std::vector<float>& data,
         length = static_cast<int>(data.size()) - offset;
     }
 
+    process(out, data.data() + offset, length);
+}
+
+void Resampler::process(std::vector<float>& out, const float* data, const int length) {
+    if (!m_isValid) throw new ResamplerError("Resampler is invalid");
+
     uint32_t ilen = length;
     uint32_t olen;
     _p->err = speex_resampler_get_expected_output_frame_count(_p->st, ilen, &olen);
@@ -104,8 +110,7 @@ void Resampler::process(std::vector<float>& out, const std::vector<float>& data,
 
     out.resize(olen);
 
-    _p->err = speex_resampler_process_float(_p->st, 0, data.data() + offset, &ilen,
-                                            out.data(), &olen);
+    _p->err = speex_resampler_process_float(_p->st, 0, data, &ilen, out.data(), &olen);
     if (_p->err != 0) {
         throw new ResamplerError("Speex process error: %s",
                                  speex_resampler_strerror(_p->err));
@@ -32,6 +32,9 @@ class Resampler final {
     std::vector<float> process(const std::vector<float>& data, int offset = 0,
                                int length = -1);
 
+    // Raw pointer version, for callers that don't keep their input in a vector.
+    void process(std::vector<float>& out, const float* data, int length);
+
     // Return # of input frames needed to a given # of output frames.
     [[nodiscard]] int requiredInputFrames(int outputLength) const;
 
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+#include "routines.h"
+
+/* Aberth-Ehrlich iteration: all roots are refined at once, each one pushed
+   away from the others so that they don't converge on the same root. It
+   converges cubically near the roots, so starting from the previous frame's
+   roots usually takes a few passes. Each pass costs O(order^2) and there are
+   at most context.maxRootIterations of them. */
+
+#define ABERTH_TOL 1.e-10 /* Max relative correction of a converged root */
+#define REAL_TOL 1.e-8    /* Max relative imaginary part of a real root */
+
+/* 1 / z without the inf/nan handling of std::complex division, which is
+   several times slower and not needed here */
+static inline std::complex<double> reciprocal(const std::complex<double> z) {
+    const double norm = z.real() * z.real() + z.imag() * z.imag();
+    return {z.real() / norm, -z.imag() / norm};
+}
+
+bool aberth(LpcContext& context, const std::vector<double>& a, int order,
+            std::vector<double>& rootr, std::vector<double>& rooti) {
+    /* Rootr and rooti are assumed to contain starting points for the root
+       search on entry to aberth(). */
+
+    if (order < 1 || a[order] == 0.) return false;
+
+    auto& z = context.roots;
+    z.resize(order);
+
+    /* Turn each starting point a little, by a different angle, so that real
+       and conjugate starting points neither stay on the real axis nor mirror
+       each other, and coincident ones come apart. */
+    for (int i = 0; i < order; ++i) {
+        std::complex<double> start(rootr[i], rooti[i]);
+        if (std::abs(start) < 1.e-3) start = 1.;
+        z[i] = start * std::polar(1., .001 * (i + 1));
+    }
+
+    bool converged = false;
+    for (int itcnt = 0; itcnt < context.maxRootIterations && !converged; ++itcnt) {
+        converged = true;
+        for (int i = 0; i < order; ++i) {
+            /* p(z) and p'(z) by Horner's rule */
+            std::complex<double> p = a[order];
+            std::complex<double> dp = 0.;
+            for (int k = order - 1; k >= 0; --k) {
+                dp = dp * z[i] + p;
+                p = p * z[i] + a[k];
+            }
+            if (p == 0.) continue; /* landed on a root */
+            if (dp == 0.) return false;
+
+            const std::complex<double> ratio = p * reciprocal(dp);
+            std::complex<double> repulsion = 0.;
+            for (int j = 0; j < order; ++j) {
+                if (j != i) repulsion += reciprocal(z[i] - z[j]);
+            }
+            const std::complex<double> step = ratio * reciprocal(1. - ratio * repulsion);
+            z[i] -= step;
+
+            if (!std::isfinite(z[i].real()) || !std::isfinite(z[i].imag())) return false;
+            if (std::abs(step) > ABERTH_TOL * std::max(1., std::abs(z[i]))) {
+                converged = false;
+            }
+        }
+    }
+    if (!converged) return false;
+
+    /* Same layout as lbpoly(): each conjugate pair is stored next to each
+       other with exactly opposite imaginary parts, real roots have none. */
+    std::sort(z.begin(), z.end(), [](const auto& l, const auto& r) {
+        return l.imag() > r.imag();
+    });
+
+    int n = 0;
+    for (const auto& root : z) {
+        const double tol = REAL_TOL * std::max(1., std::abs(root));
+        if (root.imag() > tol) {
+            if (n + 2 > order) return false;
+            rootr[n] = rootr[n + 1] = root.real();
+            rooti[n] = root.imag();
+            rooti[n + 1] = -root.imag();
+            n += 2;
+        } else if (root.imag() >= -tol) {
+            if (n + 1 > order) return false;
+            rootr[n] = root.real();
+            rooti[n] = 0.;
+            ++n;
+        }
+    }
+    return n == order;
+}
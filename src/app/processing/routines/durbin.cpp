@@ -1,8 +1,8 @@
 #include "routines.h"
 
-void durbin(const std::vector<double>& r, std::vector<double>& k, std::vector<double>& a,
-            int p, double* ex) {
-    static std::vector<double> b(MAXORDER);
+void durbin(LpcContext& context, const std::vector<double>& r, std::vector<double>& k,
+            std::vector<double>& a, int p, double* ex) {
+    auto& b = context.durbinB;
 
     double e = r[0];
     k[0] = -r[1] / e;
@@ -1,21 +1,36 @@
 #include "routines.h"
 
-bool formant(int lpcOrder, double sFreq, std::vector<double>& lpca, int* nForm,
-             std::vector<double>& freq, std::vector<double>& band, bool init) {
-    std::vector<double> rr(lpcOrder + 1);
-    std::vector<double> ri(lpcOrder + 1);
+bool formant(LpcContext& context, int lpcOrder, double sFreq, std::vector<double>& lpca,
+             int* nForm, std::vector<double>& freq, std::vector<double>& band,
+             bool init) {
+    auto& rr = context.rootr;
+    auto& ri = context.rooti;
 
-    if (init) { /* set up starting points for the root search near unit circle */
+    if (rr.size() != lpcOrder + 1) {
+        rr.resize(lpcOrder + 1);
+        ri.resize(lpcOrder + 1);
+        init = true;
+    }
+
+    /* set up starting points for the root search near unit circle */
+    const auto neutralStart = [&] {
         const double x = M_PI / (lpcOrder + 1);
         for (int i = 0; i <= lpcOrder; ++i) {
             const double flo = lpcOrder - i;
             rr[i] = 2. * cos((flo + .5) * x);
             ri[i] = 2. * sin((flo + .5) * x);
         }
-    }
+    };
+
+    if (init) neutralStart();
 
     /* find the roots of the LPC polynomial */
-    if (!lbpoly(lpca, lpcOrder, rr, ri)) { /* was there a problem in the root finder? */
+    const bool found = (context.rootSolver == ROOTS_ABERTH)
+                           ? aberth(context, lpca, lpcOrder, rr, ri)
+                           : lbpoly(context, lpca, lpcOrder, rr, ri);
+    if (!found) { /* was there a problem in the root finder? */
+        /* don't warm-start the next frame from an unfinished search */
+        if (context.rootSolver == ROOTS_ABERTH) neutralStart();
         *nForm = 0;
         return false;
     }
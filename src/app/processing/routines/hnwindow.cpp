@@ -1,8 +1,8 @@
 #include "routines.h"
 
-void hnwindow(const std::vector<double>& in, int ioff, std::vector<double>& out, int n,
-              double preEmphasis) {
-    static std::vector<double> wind;
+void hnwindow(LpcContext& context, const std::vector<double>& in, int ioff,
+              std::vector<double>& out, int n, double preEmphasis) {
+    auto& wind = context.hannWindow;
 
     if (wind.size() != n) {
         wind.resize(n);
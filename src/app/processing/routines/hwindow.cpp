@@ -1,8 +1,8 @@
 #include "routines.h"
 
-void hwindow(const std::vector<double>& in, int ioff, std::vector<double>& out, int n,
-             double preEmphasis) {
-    static std::vector<double> wind;
+void hwindow(LpcContext& context, const std::vector<double>& in, int ioff,
+             std::vector<double>& out, int n, double preEmphasis) {
+    auto& wind = context.hammingWindow;
 
     if (wind.size() != n) {
         wind.resize(n);
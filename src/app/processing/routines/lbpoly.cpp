@@ -7,16 +7,13 @@
 #define MAX_TRYS 100  /* Max number of times to try new starts */
 #define MAX_ERR 1.e-6 /* Max acceptable error in quad factor */
 
-/* Random generator */
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::uniform_real_distribution<> distrib(-0.5, 0.5);
-
-bool lbpoly(std::vector<double>& a, int order, std::vector<double>& rootr,
-            std::vector<double>& rooti) {
+bool lbpoly(LpcContext& context, std::vector<double>& a, int order,
+            std::vector<double>& rootr, std::vector<double>& rooti) {
     /* Rootr and rooti are assumed to contain starting points for the root
        search on entry to lbpoly(). */
 
+    std::uniform_real_distribution<> distrib(-0.5, 0.5);
+
     const double lim0 = 0.5 * sqrt(std::numeric_limits<double>::max());
 
     std::vector<double> b(order + 1);
@@ -83,8 +80,8 @@ bool lbpoly(std::vector<double>& a, int order, std::vector<double>& rootr,
             if (found)
                 break;
             else { /* try some new starting values */
-                p = distrib(gen);
-                q = distrib(gen);
+                p = distrib(context.rng);
+                q = distrib(context.rng);
             }
         } /* for ntrys */
 
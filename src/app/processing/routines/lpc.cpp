@@ -1,9 +1,9 @@
 #include "routines.h"
 
-bool lpc(int lpcOrd, double lpcStabl, int wsize, const std::vector<double>& data,
-         int dataOff, std::vector<double>& lpca, double* rms, double preEmphasis,
-         WindowType windowType) {
-    static std::vector<double> dwind;
+bool lpc(LpcContext& context, int lpcOrd, double lpcStabl, int wsize,
+         const std::vector<double>& data, int dataOff, std::vector<double>& lpca,
+         double* rms, double preEmphasis, WindowType windowType) {
+    auto& dwind = context.windowed;
     // static std::vector<double> rho(MAXORDER + 1);
     // static std::vector<double> k(MAXORDER + 1);
     // static std::vector<double> a(MAXORDER);
@@ -13,7 +13,7 @@ bool lpc(int lpcOrd, double lpcStabl, int wsize, const std::vector<double>& data
         dwind.resize(wsize);
     }
 
-    w_window(data, dataOff, dwind, wsize, preEmphasis, windowType);
+    w_window(context, data, dataOff, dwind, wsize, preEmphasis, windowType);
 
     // double en, er;
     // autoc(wsize, dwind, lpcOrd, rho, &en);
@@ -1,18 +1,37 @@
 
+#include <algorithm>
 #include <iostream>
 
+#include "../thread/workerpool.h"
 #include "routines.h"
 
-PoleArray lpc_poles(const std::vector<double>& data, double sampleRate,
-                    double windowDuration, double frameInterval, int lpcOrder,
-                    double preEmphasis, LpcType lpcType, WindowType windowType) {
+namespace {
+
+struct FrameSetup {
+    double sampleRate;
+    double windowDuration;
+    double frameInterval;
+    int lpcOrder;
+    double preEmphasis;
+    LpcType lpcType;
+    WindowType windowType;
+    int size;
+    int step;
+    int numFrames;
+};
+
+/* Returns false if the parameters don't give any frame. */
+bool setupFrames(const std::vector<double>& data, double sampleRate,
+                 double windowDuration, double frameInterval, int lpcOrder,
+                 double preEmphasis, LpcType lpcType, WindowType windowType,
+                 FrameSetup& setup) {
     /* Force "standard" stabilized covariance (a la bsa) */
     if (lpcType == LPC_BSA) {
         windowDuration = 0.025;
         preEmphasis = exp(-62.831853 * 90. / sampleRate);
     }
     if (lpcOrder > MAXORDER || lpcOrder < 2) {
-        return {};
+        return false;
     }
     windowDuration = integerize(windowDuration, sampleRate);
     frameInterval = integerize(frameInterval, sampleRate);
@@ -25,64 +44,154 @@ PoleArray lpc_poles(const std::vector<double>& data, double sampleRate,
     const int numFrames =
         static_cast<int>((static_cast<double>(length) / sampleRate - windowDuration) / frameInterval);
 
-    if (numFrames >= 1) {
-        const double lpcStabl = 70.0;
-        double energy;
-        std::vector<double> lpca(lpcOrder + 1);
-
-        std::vector<Pole> pole(numFrames);
-        bool init = true;
-        int dataOff = 0;
-        for (int j = 0; j < numFrames; ++j, dataOff += step) {
-            pole[j].offset = dataOff;
-
-            switch (lpcType) {
-                case LPC_AUTOC:
-                    if (!lpc(lpcOrder, lpcStabl, size, data, dataOff, lpca, &energy,
-                             preEmphasis, windowType)) {
-                        std::cerr << "Problems with lpc() in LpcPoles" << std::endl;
-                    }
-                    break;
-                case LPC_BSA:
-                    if (!lpcbsa(lpcOrder, lpcStabl, size, data, dataOff, lpca, &energy,
-                                preEmphasis)) {
-                        std::cerr << "Problems with lpcbsa() in LpcPoles" << std::endl;
-                    }
-                    break;
-                case LPC_COVAR: {
-                    int order = lpcOrder;
-                    double alpha, r0;
-
-                    /// TODO: check if wtype=0 or forward wtype
-                    w_covar(data, dataOff, &order, size, 0, lpca, &alpha, &r0,
-                            preEmphasis, WINDOW_RECTANGULAR);
-                    if (order != lpcOrder || alpha <= 0.0) {
-                        std::cerr
-                            << "Problems with w_covar() in LpcPoles; alpha:" << alpha
-                            << "  order:" << order << std::endl;
-                    }
-                    energy = sqrt(r0 / (size - order));
-                    break;
+    if (numFrames < 1) {
+        std::cerr << "Bad buffer in lpc_poles()" << std::endl;
+        return false;
+    }
+
+    setup = {sampleRate, windowDuration, frameInterval, lpcOrder, preEmphasis,
+             lpcType,    windowType,     size,          step,     numFrames};
+    return true;
+}
+
+/* Start the root search and the dither afresh for a chunk. */
+void startChunk(LpcContext& context, const int64_t chunk) {
+    context.rng.seed(static_cast<uint32_t>(LpcContext::defaultSeed + chunk));
+    context.restartRoots = true;
+}
+
+/* State that a chunk carries from one frame to the next. */
+void carryOver(const LpcContext& from, LpcContext& to) {
+    to.rootr = from.rootr;
+    to.rooti = from.rooti;
+    to.restartRoots = from.restartRoots;
+    to.rng = from.rng;
+}
+
+/* LPC pole computation for frames [first, last), frame 0 being frame
+   firstFrame of the whole analysis. Chunk boundaries restart the search. */
+void analyseFrames(LpcContext& context, const std::vector<double>& data,
+                   const FrameSetup& setup, const int first, const int last,
+                   const int64_t firstFrame, const int chunkFrames,
+                   std::vector<Pole>& pole) {
+    const auto& [sampleRate, windowDuration, frameInterval, lpcOrder, preEmphasis,
+                 lpcType, windowType, size, step, numFrames] = setup;
+
+    const double lpcStabl = 70.0;
+    double energy;
+    std::vector<double> lpca(lpcOrder + 1);
+
+    int dataOff = first * step;
+    for (int j = first; j < last; ++j, dataOff += step) {
+        if ((firstFrame + j) % chunkFrames == 0) {
+            startChunk(context, (firstFrame + j) / chunkFrames);
+        }
+        pole[j].offset = dataOff;
+
+        switch (lpcType) {
+            case LPC_AUTOC:
+                if (!lpc(context, lpcOrder, lpcStabl, size, data, dataOff, lpca, &energy,
+                         preEmphasis, windowType)) {
+                    std::cerr << "Problems with lpc() in LpcPoles" << std::endl;
                 }
+                break;
+            case LPC_BSA:
+                if (!lpcbsa(context, lpcOrder, lpcStabl, size, data, dataOff, lpca,
+                            &energy, preEmphasis)) {
+                    std::cerr << "Problems with lpcbsa() in LpcPoles" << std::endl;
+                }
+                break;
+            case LPC_COVAR: {
+                int order = lpcOrder;
+                double alpha, r0;
+
+                /// TODO: check if wtype=0 or forward wtype
+                w_covar(context, data, dataOff, &order, size, 0, lpca, &alpha, &r0,
+                        preEmphasis, WINDOW_RECTANGULAR);
+                if (order != lpcOrder || alpha <= 0.0) {
+                    std::cerr << "Problems with w_covar() in LpcPoles; alpha:" << alpha
+                              << "  order:" << order << std::endl;
+                }
+                energy = sqrt(r0 / (size - order));
+                break;
             }
-            pole[j].change = 0.0;
-            pole[j].rms = energy;
-            /* don't waste time on low energy frames */
-            if (energy > 1.0) {
-                int numForm;
-                formant(lpcOrder, sampleRate, lpca, &numForm, pole[j].freq, pole[j].band,
-                        init);
-                pole[j].npoles = numForm;
-                init = false; /* use old poles to start next search */
-            } else {
-                /* write out no pole frequencies */
-                pole[j].npoles = 0;
-                init = true; /* restart root search in a neutral zone */
-            }
-        } /* end LPC pole computation for all frames */
-        return {pole, static_cast<int>(pole.size()), 1. / frameInterval};
-    } else {
-        std::cerr << "Bad buffer in lpc_poles()" << std::endl;
+        }
+        pole[j].change = 0.0;
+        pole[j].rms = energy;
+        /* don't waste time on low energy frames */
+        if (energy > 1.0) {
+            int numForm;
+            formant(context, lpcOrder, sampleRate, lpca, &numForm, pole[j].freq,
+                    pole[j].band, context.restartRoots);
+            pole[j].npoles = numForm;
+            context.restartRoots = false; /* use old poles to start next search */
+        } else {
+            /* write out no pole frequencies */
+            pole[j].npoles = 0;
+            context.restartRoots = true; /* restart root search in a neutral zone */
+        }
+    } /* end LPC pole computation for all frames */
+}
+
+}  // namespace
+
+PoleArray lpc_poles(LpcContext& context, const std::vector<double>& data,
+                    double sampleRate, double windowDuration, double frameInterval,
+                    int lpcOrder, double preEmphasis, LpcType lpcType,
+                    WindowType windowType, const int64_t firstFrame,
+                    const int chunkFrames) {
+    FrameSetup setup;
+    if (!setupFrames(data, sampleRate, windowDuration, frameInterval, lpcOrder,
+                     preEmphasis, lpcType, windowType, setup)) {
+        return {};
+    }
+
+    std::vector<Pole> pole(setup.numFrames);
+    analyseFrames(context, data, setup, 0, setup.numFrames, firstFrame,
+                  std::max(chunkFrames, 1), pole);
+    return {pole, static_cast<int>(pole.size()), 1. / setup.frameInterval};
+}
+
+PoleArray lpc_poles(reformant::WorkerPool& pool, std::vector<LpcContext>& contexts,
+                    LpcContext& context, const std::vector<double>& data,
+                    double sampleRate, double windowDuration, double frameInterval,
+                    int lpcOrder, double preEmphasis, LpcType lpcType,
+                    WindowType windowType, const int64_t firstFrame,
+                    const int chunkFrames) {
+    FrameSetup setup;
+    if (!setupFrames(data, sampleRate, windowDuration, frameInterval, lpcOrder,
+                     preEmphasis, lpcType, windowType, setup)) {
         return {};
     }
-}
\ No newline at end of file
+
+    contexts.resize(pool.workerCount());
+
+    /* Frames where a task starts: the chunk boundaries, and frame 0 which may
+       be in the middle of a chunk. */
+    const int chunkLength = std::max(chunkFrames, 1);
+    std::vector<int> starts{0};
+    const int firstBoundary =
+        static_cast<int>((chunkLength - firstFrame % chunkLength) % chunkLength);
+    for (int j = (firstBoundary > 0) ? firstBoundary : chunkLength; j < setup.numFrames;
+         j += chunkLength) {
+        starts.push_back(j);
+    }
+    const int taskCount = static_cast<int>(starts.size());
+    starts.push_back(setup.numFrames);
+
+    /* The first task runs on context, to carry on with a chunk left unfinished
+       by the previous call. The others start their chunk afresh. */
+    int lastWorker = -1;
+    std::vector<Pole> pole(setup.numFrames);
+    pool.parallelFor(taskCount, [&](const int task, const int worker) {
+        LpcContext& taskContext = (task == 0) ? context : contexts[worker];
+        analyseFrames(taskContext, data, setup, starts[task], starts[task + 1],
+                      firstFrame, chunkLength, pole);
+        if (task == taskCount - 1) lastWorker = worker;
+    });
+
+    /* Leave the last chunk's state in context for the next call. */
+    if (taskCount > 1) carryOver(contexts[lastWorker], context);
+
+    return {pole, static_cast<int>(pole.size()), 1. / setup.frameInterval};
+}
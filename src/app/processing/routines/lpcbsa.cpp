@@ -3,16 +3,13 @@
 
 #include "routines.h"
 
-/* Random generator */
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::uniform_real_distribution distrib(0.0, 1.0);
-
-bool lpcbsa(const int np, const double lpcStabl, int wind, const std::vector<double>& data,
-            const int dataOff, std::vector<double>& lpc, double* energy, const double preEmphasis) {
+bool lpcbsa(LpcContext& context, const int np, const double lpcStabl, int wind,
+            const std::vector<double>& data, const int dataOff, std::vector<double>& lpc,
+            double* energy, const double preEmphasis) {
     (void) lpcStabl;
 
-    static std::vector<double> w;
+    auto& w = context.bsaWindow;
+    std::uniform_real_distribution distrib(0.0, 1.0);
 
     if (w.size() != wind) {
         /* need to compute a new window? */
@@ -28,7 +25,7 @@ bool lpcbsa(const int np, const double lpcStabl, int wind, const std::vector<dou
 
     std::vector<double> sig(wind);
     for (int i = 0; i < wind; ++i) {
-        sig[i] = data[dataOff + i] + .016 * distrib(gen) - .008;
+        sig[i] = data[dataOff + i] + .016 * distrib(context.rng) - .008;
     }
     for (int i = 1; i < wind; ++i) {
         sig[i - 1] = sig[i] - preEmphasis * sig[i - 1];
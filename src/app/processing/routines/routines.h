@@ -2,8 +2,15 @@
 #define REFORMANT_PROCESSING_ROUTINES_ROUTINES_H
 
 #include <cmath>
+#include <complex>
+#include <cstdint>
+#include <random>
 #include <vector>
 
+namespace reformant {
+class WorkerPool;
+}
+
 inline double integerize(const double time, const double freq) {
     const int i = static_cast<int>(std::round(freq * time));
     return static_cast<double>(i) / freq;
@@ -22,6 +29,15 @@ enum LpcType {
     LPC_COVAR,
 };
 
+// Polynomial root finder used by formant().
+enum RootSolver {
+    // Bairstow's method, with random restarts when it doesn't converge.
+    ROOTS_BAIRSTOW,
+    // Aberth-Ehrlich iteration with a fixed iteration budget. Deterministic,
+    // and cheap when started from the previous frame's roots.
+    ROOTS_ABERTH,
+};
+
 struct Pole {
     int offset;
     double rms; /* rms for current LPC analysis frame */
@@ -42,43 +58,102 @@ struct PoleArray {
 
 inline constexpr int MAXORDER = 60;
 
-PoleArray lpc_poles(const std::vector<double>& data, double sampleRate,
-                    double windowDuration, double frameInterval, int lpcOrder,
-                    double preEmphasis, LpcType lpcType, WindowType windowType);
+// Scratch state of the LPC routines, which keep none of their own. Analyses
+// that run at the same time need one context each.
+struct LpcContext {
+    // Fixed so that analyses are reproducible.
+    static constexpr uint32_t defaultSeed = 5489;
+
+    // Analysis windows, recomputed when their length changes.
+    std::vector<double> hammingWindow;
+    std::vector<double> cos4Window;
+    std::vector<double> hannWindow;
+    std::vector<double> bsaWindow;
+
+    // Windowed frame for lpc() and w_covar().
+    std::vector<double> windowed;
+
+    // w_covar() working arrays.
+    std::vector<double> covarB;
+    std::vector<double> covarBeta;
+    std::vector<double> covarGrc;
+    std::vector<double> covarCc;
+
+    // durbin() working array.
+    std::vector<double> durbinB = std::vector<double>(MAXORDER);
+
+    // Root search starting points for formant(), the previous frame's roots
+    // unless it is asked to start over.
+    std::vector<double> rootr;
+    std::vector<double> rooti;
+    // The next frame's root search starts over, at the start of a chunk and
+    // after a frame too quiet to analyse.
+    bool restartRoots = true;
+
+    RootSolver rootSolver = ROOTS_BAIRSTOW;
+    // Passes of ROOTS_ABERTH before giving up on a frame.
+    int maxRootIterations = 30;
+    // aberth() working array.
+    std::vector<std::complex<double>> roots;
+
+    // Dither in lpcbsa() and new starting points in lbpoly().
+    std::mt19937 rng{defaultSeed};
+};
+
+// Frame 0 of data is frame firstFrame of a longer analysis, which is cut
+// into chunks of chunkFrames frames counted from its start. Each chunk starts
+// its root search afresh at its first frame and seeds its dither from its
+// index. A chunk cut short by the end of data carries on from the state left
+// in context on the next call. The poles of a frame therefore only depend on
+// its chunk, not on how the analysis was split into calls.
+PoleArray lpc_poles(LpcContext& context, const std::vector<double>& data,
+                    double sampleRate, double windowDuration, double frameInterval,
+                    int lpcOrder, double preEmphasis, LpcType lpcType,
+                    WindowType windowType, int64_t firstFrame = 0, int chunkFrames = 32);
+
+// Same analysis with the chunks run in parallel on pool, with one context per
+// worker. context carries the chunks cut short between calls as above, so
+// both overloads give the same poles.
+PoleArray lpc_poles(reformant::WorkerPool& pool, std::vector<LpcContext>& contexts,
+                    LpcContext& context, const std::vector<double>& data,
+                    double sampleRate, double windowDuration, double frameInterval,
+                    int lpcOrder, double preEmphasis, LpcType lpcType,
+                    WindowType windowType, int64_t firstFrame = 0, int chunkFrames = 32);
 
 void dpform(const std::vector<Pole>& poles, int nform, double nomF1);
 
 void rwindow(const std::vector<double>& in, int ioff, std::vector<double>& out, int n,
              double preEmphasis);
 
-void hwindow(const std::vector<double>& in, int ioff, std::vector<double>& out, int n,
-             double preEmphasis);
+void hwindow(LpcContext& context, const std::vector<double>& in, int ioff,
+             std::vector<double>& out, int n, double preEmphasis);
 
-void cwindow(const std::vector<double>& in, int ioff, std::vector<double>& out, int n,
-             double preEmphasis);
+void cwindow(LpcContext& context, const std::vector<double>& in, int ioff,
+             std::vector<double>& out, int n, double preEmphasis);
 
-void hnwindow(const std::vector<double>& in, int ioff, std::vector<double>& out, int n,
-              double preEmphasis);
+void hnwindow(LpcContext& context, const std::vector<double>& in, int ioff,
+              std::vector<double>& out, int n, double preEmphasis);
 
-void w_window(const std::vector<double>& in, int ioff, std::vector<double>& out, int n,
-              double preEmphasis, WindowType type);
+void w_window(LpcContext& context, const std::vector<double>& in, int ioff,
+              std::vector<double>& out, int n, double preEmphasis, WindowType type);
 
 void autoc(int windowSize, const std::vector<double>& s, int p, std::vector<double>& r,
            double* e);
 
-void durbin(const std::vector<double>& r, std::vector<double>& k, std::vector<double>& a,
-            int p, double* ex);
+void durbin(LpcContext& context, const std::vector<double>& r, std::vector<double>& k,
+            std::vector<double>& a, int p, double* ex);
 
-bool lpc(int np, double lpcStabl, int wind, const std::vector<double>& data, int dataOff,
-         std::vector<double>& lpc, double* energy, double preEmphasis,
-         WindowType windowType);
+bool lpc(LpcContext& context, int np, double lpcStabl, int wind,
+         const std::vector<double>& data, int dataOff, std::vector<double>& lpc,
+         double* energy, double preEmphasis, WindowType windowType);
 
-bool lpcbsa(int np, double lpcStabl, int wind, const std::vector<double>& data,
-            int dataOff, std::vector<double>& lpc, double* energy, double preEmphasis);
+bool lpcbsa(LpcContext& context, int np, double lpcStabl, int wind,
+            const std::vector<double>& data, int dataOff, std::vector<double>& lpc,
+            double* energy, double preEmphasis);
 
-bool w_covar(const std::vector<double>& data, int dataOff, int* m, int n, int istrt,
-             std::vector<double>& y, double* alpha, double* r0, double preEmphasis,
-             WindowType windowType);
+bool w_covar(LpcContext& context, const std::vector<double>& data, int dataOff, int* m,
+             int n, int istrt, std::vector<double>& y, double* alpha, double* r0,
+             double preEmphasis, WindowType windowType);
 
 void dlwrtrn(const std::vector<double>& a, int n, std::vector<double>& x,
              const std::vector<double>& y);
@@ -101,10 +176,15 @@ int dlpcwtd(const std::vector<double>& s, int ls, std::vector<double>& p, int np
 bool qquad(double a, double b, double c, double* r1r, double* r1i, double* r2r,
            double* r2i);
 
-bool lbpoly(std::vector<double>& a, int order, std::vector<double>& rootr,
-            std::vector<double>& rooti);
+bool lbpoly(LpcContext& context, std::vector<double>& a, int order,
+            std::vector<double>& rootr, std::vector<double>& rooti);
+
+bool aberth(LpcContext& context, const std::vector<double>& a, int order,
+            std::vector<double>& rootr, std::vector<double>& rooti);
 
-bool formant(int lpcOrder, double sFreq, std::vector<double>& lpca, int* nForm,
-             std::vector<double>& freq, std::vector<double>& band, bool init);
+// With init false, the root search starts from the roots of the previous call
+// on the same context.
+bool formant(LpcContext& context, int lpcOrder, double sFreq, std::vector<double>& lpca,
+             int* nForm, std::vector<double>& freq, std::vector<double>& band, bool init);
 
 #endif  // REFORMANT_PROCESSING_ROUTINES_ROUTINES_H
\ No newline at end of file
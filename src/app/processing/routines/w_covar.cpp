@@ -1,34 +1,28 @@
 #include "routines.h"
 
-bool w_covar(const std::vector<double>& xx, int xoff, int* m, int n, int istrt,
-             std::vector<double>& y, double* alpha, double* r0, double preEmphasis,
-             WindowType windowType)
-{
-    static int nold = 0;
-    static int mold = 0;
+bool w_covar(LpcContext& context, const std::vector<double>& xx, int xoff, int* m,
+             int n, int istrt, std::vector<double>& y, double* alpha, double* r0,
+             double preEmphasis, WindowType windowType) {
+    auto& x = context.windowed;
+    auto& b = context.covarB;
+    auto& beta = context.covarBeta;
+    auto& grc = context.covarGrc;
+    auto& cc = context.covarCc;
 
-    static std::vector<double> x;
-    static std::vector<double> b;
-    static std::vector<double> beta;
-    static std::vector<double> grc;
-    static std::vector<double> cc;
-
-    if (n + 1 > nold) {
+    if (n + 1 > x.size()) {
         x.resize(n + 1);
-        nold = n + 1;
     }
 
-    if (*m > mold) {
+    if (*m + 3 > cc.size()) {
         const int mn = *m;
 
         b.resize((mn + 1) * (mn + 1) / 2);
         beta.resize(mn + 3);
         grc.resize(mn + 3);
         cc.resize(mn + 3);
-        mold = mn;
     }
 
-    w_window(xx, xoff, x, n, preEmphasis, windowType);
+    w_window(context, xx, xoff, x, n, preEmphasis, windowType);
 
     const int ibeg = istrt - 1;
     const int ibeg1 = ibeg + 1;
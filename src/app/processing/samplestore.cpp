@@ -0,0 +1,251 @@
+#include "samplestore.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#include "mappedfile.h"
+
+using namespace reformant;
+
+SampleStore::SampleStore(const SampleStorage storage)
+    : m_storage(storage),
+      m_firstSegment(0),
+      m_hotStart(0),
+      m_sweepSegment(0),
+      m_directory(nullptr),
+      m_begin(0),
+      m_size(0),
+      m_allocatedSegments(0) {}
+
+SampleStore::~SampleStore() = default;
+
+SampleStore::SampleStore(SampleStore&& other) noexcept
+    : m_storage(SampleStorage_Memory),
+      m_firstSegment(0),
+      m_hotStart(0),
+      m_sweepSegment(0),
+      m_directory(nullptr),
+      m_begin(0),
+      m_size(0),
+      m_allocatedSegments(0) {
+    *this = std::move(other);
+}
+
+SampleStore& SampleStore::operator=(SampleStore&& other) noexcept {
+    m_storage = other.m_storage;
+    m_file = std::move(other.m_file);
+    m_heapSegments = std::move(other.m_heapSegments);
+    m_segments = std::move(other.m_segments);
+    m_firstSegment = std::exchange(other.m_firstSegment, 0);
+    m_freeSegments = std::move(other.m_freeSegments);
+    m_hotStart = std::exchange(other.m_hotStart, 0);
+    m_sweepSegment = std::exchange(other.m_sweepSegment, 0);
+    m_directories = std::move(other.m_directories);
+    m_directory.store(other.m_directory.exchange(nullptr));
+    m_begin.store(other.m_begin.exchange(0));
+    m_size.store(other.m_size.exchange(0));
+    m_allocatedSegments.store(other.m_allocatedSegments.exchange(0));
+    return *this;
+}
+
+void SampleStore::append(const float* samples, int64_t count) {
+    int64_t size = m_size.load(std::memory_order_relaxed);
+
+    while (count > 0) {
+        const int64_t segment = size >> segmentShift;
+        const int64_t position = size & segmentMask;
+
+        const int64_t slot = segment - m_firstSegment;
+
+        if (slot >= static_cast<int64_t>(m_segments.size())) {
+            Directory* directory = m_directory.load(std::memory_order_relaxed);
+            if (directory == nullptr || slot >= directory->capacity) {
+                growDirectory();
+                directory = m_directory.load(std::memory_order_relaxed);
+            }
+            m_segments.push_back(allocateSegment());
+            directory->segments[segment & (directory->capacity - 1)] =
+                m_segments.back().data;
+
+            if (m_file) evictColdSegments();
+        }
+
+        const int64_t n = std::min(count, segmentLength - position);
+        std::copy_n(samples, n, m_segments[slot].data + position);
+
+        samples += n;
+        count -= n;
+        size += n;
+
+        // Publish the new samples to the readers.
+        m_size.store(size, std::memory_order_release);
+    }
+}
+
+void SampleStore::append(const std::vector<float>& samples) {
+    append(samples.data(), static_cast<int64_t>(samples.size()));
+}
+
+void SampleStore::clear(const int64_t begin) {
+    m_begin.store(begin, std::memory_order_release);
+    m_size.store(begin, std::memory_order_release);
+    m_directory.store(nullptr, std::memory_order_release);
+    m_directories.clear();
+    m_segments.clear();
+    m_firstSegment = begin >> segmentShift;
+    m_hotStart = m_firstSegment;
+    m_sweepSegment = m_firstSegment;
+    m_freeSegments.clear();
+    m_heapSegments.clear();
+    m_file.reset();
+    m_allocatedSegments.store(0, std::memory_order_relaxed);
+}
+
+void SampleStore::dropBefore(int64_t index) {
+    index = std::min(index, size());
+
+    // The segment being appended to is kept, even if it is empty.
+    while (m_segments.size() > 1 && (m_firstSegment + 1) << segmentShift <= index) {
+        m_freeSegments.push_back(m_segments.front());
+        m_segments.pop_front();
+        ++m_firstSegment;
+    }
+
+    if (index > begin()) {
+        m_begin.store(std::max(begin(), m_firstSegment << segmentShift),
+                      std::memory_order_release);
+    }
+}
+
+SampleStorage SampleStore::storage() const { return m_storage; }
+
+int64_t SampleStore::begin() const { return m_begin.load(std::memory_order_acquire); }
+
+int64_t SampleStore::size() const { return m_size.load(std::memory_order_acquire); }
+
+bool SampleStore::empty() const { return size() == begin(); }
+
+float SampleStore::operator[](const int64_t index) const {
+    return segment(index >> segmentShift)[index & segmentMask];
+}
+
+void SampleStore::copy(int64_t offset, int64_t length, float* out) const {
+    while (length > 0) {
+        const int64_t position = offset & segmentMask;
+        const int64_t n = std::min(length, segmentLength - position);
+
+        std::copy_n(segment(offset >> segmentShift) + position, n, out);
+
+        out += n;
+        offset += n;
+        length -= n;
+    }
+}
+
+std::span<const float> SampleStore::contiguous(const int64_t offset,
+                                              const int64_t maxLength) const {
+    const int64_t position = offset & segmentMask;
+    const int64_t n = std::min(maxLength, segmentLength - position);
+    return {segment(offset >> segmentShift) + position, static_cast<size_t>(n)};
+}
+
+int SampleStore::segmentCount() const { return static_cast<int>(m_segments.size()); }
+
+uint64_t SampleStore::bytesAllocated() const {
+    return m_allocatedSegments.load(std::memory_order_relaxed) * segmentLength *
+           sizeof(float);
+}
+
+const float* SampleStore::segment(const int64_t index) const {
+    const Directory* directory = m_directory.load(std::memory_order_acquire);
+    return directory->segments[index & (directory->capacity - 1)];
+}
+
+void SampleStore::growDirectory() {
+    const Directory* old = m_directory.load(std::memory_order_relaxed);
+    const int64_t capacity = (old != nullptr) ? 2 * old->capacity : 64;
+
+    auto directory = std::make_unique<Directory>();
+    directory->capacity = capacity;
+    directory->segments = std::make_unique<float*[]>(capacity);
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        const int64_t segment = m_firstSegment + static_cast<int64_t>(i);
+        directory->segments[segment & (capacity - 1)] = m_segments[i].data;
+    }
+
+    m_directory.store(directory.get(), std::memory_order_release);
+    m_directories.push_back(std::move(directory));
+}
+
+SampleStore::Segment SampleStore::allocateSegment() {
+    if (!m_freeSegments.empty()) {
+        const Segment segment = m_freeSegments.back();
+        m_freeSegments.pop_back();
+        return segment;
+    }
+
+    if (m_storage == SampleStorage_MappedFile) {
+        if (!m_file) {
+            m_file = std::make_unique<MappedFile>(segmentLength * sizeof(float));
+        }
+        if (auto block = static_cast<float*>(m_file->mapBlock())) {
+            m_allocatedSegments.fetch_add(1, std::memory_order_relaxed);
+            return {block, true};
+        }
+        std::cerr << "SampleStore: falling back to memory for this segment"
+                  << std::endl;
+    }
+
+    m_heapSegments.push_back(std::make_unique<float[]>(segmentLength));
+    m_allocatedSegments.fetch_add(1, std::memory_order_relaxed);
+    return {m_heapSegments.back().get(), false};
+}
+
+void SampleStore::evictColdSegments() {
+    const auto evict = [&](const int64_t number) {
+        const Segment& segment = m_segments[number - m_firstSegment];
+        if (segment.isMapped) m_file->evict(segment.data);
+    };
+
+    // Segments leave the hot window in order, each one is evicted once then.
+    const int64_t hotStart = m_firstSegment + segmentCount() - residentSegments;
+    for (m_hotStart = std::max(m_hotStart, m_firstSegment); m_hotStart < hotStart;
+         ++m_hotStart) {
+        evict(m_hotStart);
+    }
+
+    // Pages faulted back in by readers scrolling through old audio would stay
+    // resident forever, so one older segment is evicted again each time, going
+    // round the whole history.
+    if (m_hotStart > m_firstSegment) {
+        if (m_sweepSegment < m_firstSegment || m_sweepSegment >= m_hotStart) {
+            m_sweepSegment = m_firstSegment;
+        }
+        evict(m_sweepSegment++);
+    }
+}
+
+SampleView::SampleView() : m_store(nullptr), m_offset(0), m_length(0) {}
+
+SampleView::SampleView(const SampleStore* store, const int64_t offset,
+                       const int64_t length)
+    : m_store(store), m_offset(offset), m_length(length) {}
+
+int64_t SampleView::offset() const { return m_offset; }
+
+int64_t SampleView::size() const { return m_length; }
+
+bool SampleView::empty() const { return m_length == 0; }
+
+float SampleView::operator[](const int64_t index) const {
+    return (*m_store)[m_offset + index];
+}
+
+SampleView SampleView::subview(const int64_t offset, const int64_t length) const {
+    return {m_store, m_offset + offset, length};
+}
+
+void SampleView::copyTo(float* out) const {
+    if (m_length > 0) m_store->copy(m_offset, m_length, out);
+}
@@ -0,0 +1,167 @@
+#ifndef REFORMANT_PROCESSING_SAMPLESTORE_H
+#define REFORMANT_PROCESSING_SAMPLESTORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace reformant {
+
+class MappedFile;
+
+enum SampleStorage {
+    SampleStorage_Memory,
+    // Segments live in a memory-mapped scratch file. Only the most recent
+    // ones are kept resident, older ones are left to the OS page cache.
+    SampleStorage_MappedFile,
+};
+
+// Append-only sample buffer made of fixed-size segments.
+// Segments never move once allocated, so growing the store never copies
+// the samples that are already in it. Whole segments can be dropped from the
+// front to bound memory: indices are absolute and keep counting from where
+// the store started, valid ones are [begin(), size()).
+//
+// One writer may append while any number of readers access samples below
+// size(): the size is published with release semantics after the samples are
+// written. clear(), dropBefore() and assignment are structural changes and
+// must not run concurrently with readers.
+class SampleStore final {
+   public:
+    // 2^18 floats = 1 MiB per segment.
+    static constexpr int segmentShift = 18;
+    static constexpr int64_t segmentLength = int64_t(1) << segmentShift;
+    static constexpr int64_t segmentMask = segmentLength - 1;
+
+    // Number of most recent segments kept resident with SampleStorage_MappedFile.
+    static constexpr int residentSegments = 8;
+
+    explicit SampleStore(SampleStorage storage = SampleStorage_Memory);
+    ~SampleStore();
+    SampleStore(SampleStore&& other) noexcept;
+    SampleStore& operator=(SampleStore&& other) noexcept;
+
+    void append(const float* samples, int64_t count);
+    void append(const std::vector<float>& samples);
+
+    // Drop all samples. The next one appended gets index begin.
+    void clear(int64_t begin = 0);
+
+    // Drop the segments that only hold samples before index. Their memory is
+    // reused for the next segments.
+    void dropBefore(int64_t index);
+
+    [[nodiscard]] SampleStorage storage() const;
+
+    // Index of the first sample that is still stored.
+    [[nodiscard]] int64_t begin() const;
+    // One past the index of the last sample.
+    [[nodiscard]] int64_t size() const;
+    [[nodiscard]] bool empty() const;
+
+    float operator[](int64_t index) const;
+
+    // Copy [offset, offset + length) into out. The range must be in bounds.
+    void copy(int64_t offset, int64_t length, float* out) const;
+
+    // Longest contiguous run of samples starting at offset, capped to maxLength.
+    [[nodiscard]] std::span<const float> contiguous(int64_t offset,
+                                                    int64_t maxLength) const;
+
+    [[nodiscard]] int segmentCount() const;
+
+    // Size of the segments held, in use or kept for reuse, mapped ones
+    // included. Can be read while appending.
+    [[nodiscard]] uint64_t bytesAllocated() const;
+
+   private:
+    // Segment index read by the readers, a ring indexed by segment number
+    // modulo its capacity. When it fills up a bigger copy is published and the
+    // old one is kept alive until clear(), so readers that still hold it keep
+    // seeing valid segment pointers.
+    struct Directory {
+        int64_t capacity;
+        std::unique_ptr<float*[]> segments;
+    };
+
+    // A stored segment, which lives either in the scratch file or on the heap.
+    struct Segment {
+        float* data;
+        bool isMapped;
+    };
+
+    [[nodiscard]] const float* segment(int64_t index) const;
+
+    void growDirectory();
+
+    Segment allocateSegment();
+
+    // Evict the segments that left the hot window, and one older segment
+    // again in turn.
+    void evictColdSegments();
+
+    SampleStorage m_storage;
+    std::unique_ptr<MappedFile> m_file;
+    std::vector<std::unique_ptr<float[]>> m_heapSegments;
+
+    // Writer-side list of the stored segments, in order, starting with
+    // segment number m_firstSegment.
+    std::deque<Segment> m_segments;
+    int64_t m_firstSegment;
+    // Dropped segments, reused before allocating new ones.
+    std::vector<Segment> m_freeSegments;
+    // With SampleStorage_MappedFile, the segments before number m_hotStart left
+    // the hot window and were evicted. Older segments are evicted again from
+    // m_sweepSegment on, in case readers paged them back in.
+    int64_t m_hotStart;
+    int64_t m_sweepSegment;
+    std::vector<std::unique_ptr<Directory>> m_directories;
+    std::atomic<Directory*> m_directory;
+    std::atomic<int64_t> m_begin;
+    std::atomic<int64_t> m_size;
+    std::atomic<int64_t> m_allocatedSegments;
+};
+
+// Read-only window over a range of a SampleStore, which reads the samples in
+// place. It doesn't own anything: it is only valid for as long as the store
+// it was taken from isn't cleared or replaced.
+class SampleView final {
+   public:
+    SampleView();
+    SampleView(const SampleStore* store, int64_t offset, int64_t length);
+
+    [[nodiscard]] int64_t offset() const;
+    [[nodiscard]] int64_t size() const;
+    [[nodiscard]] bool empty() const;
+
+    float operator[](int64_t index) const;
+
+    [[nodiscard]] SampleView subview(int64_t offset, int64_t length) const;
+
+    void copyTo(float* out) const;
+
+    // Calls f(std::span<const float>) for each contiguous piece, in order.
+    template <typename F>
+    void forEachSpan(F&& f) const {
+        int64_t position = m_offset;
+        int64_t remaining = m_length;
+        while (remaining > 0) {
+            const auto span = m_store->contiguous(position, remaining);
+            f(span);
+            position += static_cast<int64_t>(span.size());
+            remaining -= static_cast<int64_t>(span.size());
+        }
+    }
+
+   private:
+    const SampleStore* m_store;
+    int64_t m_offset;
+    int64_t m_length;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_SAMPLESTORE_H
@@ -0,0 +1,95 @@
+#include "staleranges.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace reformant;
+
+StaleRanges::StaleRanges(const double chunkLength)
+    : m_chunkLength(chunkLength), m_viewMin(0), m_viewMax(0) {}
+
+void StaleRanges::clear() { m_ranges.clear(); }
+
+bool StaleRanges::empty() const { return m_ranges.empty(); }
+
+void StaleRanges::mark(const double timeMin, const double timeMax) {
+    if (timeMax <= timeMin) return;
+
+    m_ranges.emplace_back(timeMin, timeMax);
+    std::sort(m_ranges.begin(), m_ranges.end());
+
+    // Merge overlapping ranges.
+    size_t merged = 0;
+    for (size_t i = 1; i < m_ranges.size(); ++i) {
+        if (m_ranges[i].first <= m_ranges[merged].second) {
+            m_ranges[merged].second =
+                std::max(m_ranges[merged].second, m_ranges[i].second);
+        } else {
+            m_ranges[++merged] = m_ranges[i];
+        }
+    }
+    m_ranges.resize(merged + 1);
+}
+
+void StaleRanges::dropBefore(const double t) {
+    while (!m_ranges.empty() && m_ranges.front().second <= t) {
+        m_ranges.erase(m_ranges.begin());
+    }
+    if (!m_ranges.empty()) {
+        m_ranges.front().first = std::max(m_ranges.front().first, t);
+    }
+}
+
+void StaleRanges::setView(const double timeMin, const double timeMax) {
+    m_viewMin = timeMin;
+    m_viewMax = timeMax;
+}
+
+bool StaleRanges::take(double& timeMin, double& timeMax) {
+    if (m_ranges.empty()) return false;
+
+    size_t chosen = m_ranges.size();
+
+    for (size_t i = 0; i < m_ranges.size(); ++i) {
+        const auto& [start, end] = m_ranges[i];
+        if (end > m_viewMin && start < m_viewMax) {
+            chosen = i;
+            timeMin = std::max(start, m_viewMin);
+            timeMax = std::min({end, m_viewMax, timeMin + m_chunkLength});
+            break;
+        }
+    }
+
+    if (chosen == m_ranges.size()) {
+        double minDistance = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < m_ranges.size(); ++i) {
+            const auto& [start, end] = m_ranges[i];
+            const double distance =
+                (end <= m_viewMin) ? m_viewMin - end : start - m_viewMax;
+            if (distance >= minDistance) continue;
+
+            minDistance = distance;
+            chosen = i;
+            // Work outwards from the view.
+            if (end <= m_viewMin) {
+                timeMax = end;
+                timeMin = std::max(start, end - m_chunkLength);
+            } else {
+                timeMin = start;
+                timeMax = std::min(end, start + m_chunkLength);
+            }
+        }
+    }
+
+    // Cut the chunk out of its range.
+    const auto [start, end] = m_ranges[chosen];
+    m_ranges.erase(m_ranges.begin() + chosen);
+    if (timeMax < end) {
+        m_ranges.insert(m_ranges.begin() + chosen, {timeMax, end});
+    }
+    if (start < timeMin) {
+        m_ranges.insert(m_ranges.begin() + chosen, {start, timeMin});
+    }
+
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef REFORMANT_PROCESSING_STALERANGES_H
+#define REFORMANT_PROCESSING_STALERANGES_H
+
+#include <utility>
+#include <vector>
+
+namespace reformant {
+
+// Sorted, disjoint time ranges of results still analysed at a previous sample
+// rate. They stay on display and are redone a chunk at a time, the part in
+// view first.
+class StaleRanges final {
+   public:
+    // Chunks handed out by take() are at most chunkLength long. (secs)
+    explicit StaleRanges(double chunkLength);
+
+    void clear();
+
+    [[nodiscard]] bool empty() const;
+
+    // Results in [timeMin, timeMax) are stale.
+    void mark(double timeMin, double timeMax);
+
+    // Results before time t were dropped, they don't need redoing anymore.
+    void dropBefore(double t);
+
+    // Range on display, redone before the rest.
+    void setView(double timeMin, double timeMax);
+
+    // Pick the next range to redo and cut it out: inside the view from its
+    // left edge first, then the nearest one outside of it. False if nothing
+    // is stale.
+    bool take(double& timeMin, double& timeMax);
+
+   private:
+    std::vector<std::pair<double, double>> m_ranges;
+    double m_chunkLength;
+    double m_viewMin;
+    double m_viewMax;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_STALERANGES_H
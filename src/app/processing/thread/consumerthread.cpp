@@ -1,12 +1,11 @@
 #include "consumerthread.h"
 
-#include <chrono>
 #include <functional>
+#include <mutex>
 #include <iostream>
 
 #include "../../state.h"
 
-using namespace std::chrono;
 using namespace reformant;
 
 ConsumerThread::ConsumerThread(AppState& appState,
@@ -27,32 +26,31 @@ void ConsumerThread::terminate() {
 }
 
 void ConsumerThread::run() const {
-    auto lastTime = steady_clock::now();
-
     appState.audioInput.setBufferCallback(
         [&](const std::vector<float>& buffer) {
-            std::lock_guard trackGuard(appState.audioTrack.mutex());
+            const auto trackLease = appState.audioTrack.lease();
             appState.audioTrack.append(buffer,
                                        appState.audioInput.sampleRate());
         });
 
     while (m_isRunning) {
+        // Wake up as soon as the stream callback has new samples. The delay is
+        // only a fallback, so that stopping the thread never hangs.
+        appState.audioInput.waitForBuffers(m_approxRetrieveDelayMs);
+
         // Retrieve buffers into track.
         appState.audioInput.retrieveBuffers();
 
-        // Wait until the appropriate duration has elapsed.
-        const auto now = steady_clock::now();
-        const int elapsed = duration_cast<milliseconds>(now - lastTime).count();
-        if (elapsed < m_approxRetrieveDelayMs) {
-            // Sleep for the remainder if it took less time.
-            std::this_thread::sleep_for(
-                milliseconds(m_approxRetrieveDelayMs - elapsed));
-        } else if (elapsed) {
-            // Log to console if it took more time than the expected delay.
-            std::cout << "Retrieving took longer than "
-                << m_approxRetrieveDelayMs << " ms" << std::endl;
+        // Dropping old audio is a structural change, but it only happens once
+        // per track segment.
+        bool needsTrim;
+        {
+            const auto trackLease = appState.audioTrack.lease();
+            needsTrim = appState.audioTrack.needsTrim();
+        }
+        if (needsTrim) {
+            std::lock_guard trackGuard(appState.audioTrack.mutex());
+            appState.audioTrack.trimToRollingWindow();
         }
-
-        lastTime = steady_clock::now();
     }
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "workerpool.h"
+
+#include <algorithm>
+
+using namespace reformant;
+
+WorkerPool::WorkerPool(const int threadCount)
+    : m_task(nullptr),
+      m_count(0),
+      m_next(0),
+      m_busy(0),
+      m_generation(0),
+      m_isStopping(false) {
+    for (int i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back([this, worker = i + 1] { run(worker); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lockGuard(m_mutex);
+        m_isStopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads) thread.join();
+}
+
+int WorkerPool::workerCount() const { return static_cast<int>(m_threads.size()) + 1; }
+
+void WorkerPool::parallelFor(const int count, const Task& task) {
+    if (count <= 0) return;
+
+    std::lock_guard callGuard(m_callMutex);
+
+    if (m_threads.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) task(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard lockGuard(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_next = 0;
+        m_busy = static_cast<int>(m_threads.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    work(0);
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = nullptr;
+}
+
+int WorkerPool::defaultThreadCount() {
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(cores - 1, 0);
+}
+
+void WorkerPool::run(const int worker) {
+    uint64_t generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_isStopping || m_generation != generation; });
+            if (m_isStopping) return;
+            generation = m_generation;
+        }
+
+        work(worker);
+
+        std::lock_guard lockGuard(m_mutex);
+        if (--m_busy == 0) m_done.notify_one();
+    }
+}
+
+void WorkerPool::work(const int worker) {
+    for (int i = m_next++; i < m_count; i = m_next++) {
+        (*m_task)(i, worker);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef REFORMANT_PROCESSING_WORKERPOOL_H
+#define REFORMANT_PROCESSING_WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace reformant {
+
+// Fixed set of threads for data-parallel loops.
+// The calling thread takes part in the loop as worker 0, so workerCount() is
+// the number of pool threads plus one. Calls from different threads are run
+// one after the other; a task must not call parallelFor() itself.
+class WorkerPool {
+   public:
+    // task(index, worker) with 0 <= worker < workerCount()
+    using Task = std::function<void(int, int)>;
+
+    explicit WorkerPool(int threadCount = defaultThreadCount());
+
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    [[nodiscard]] int workerCount() const;
+
+    // Runs task for every index in [0, count) and returns when all are done.
+    void parallelFor(int count, const Task& task);
+
+    // One thread per core, minus the one that calls parallelFor().
+    static int defaultThreadCount();
+
+   private:
+    void run(int worker);
+
+    void work(int worker);
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_callMutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Task* m_task;
+    int m_count;
+    std::atomic_int m_next;
+    int m_busy;
+    uint64_t m_generation;
+    bool m_isStopping;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_WORKERPOOL_H
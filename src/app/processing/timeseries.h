@@ -0,0 +1,252 @@
+#ifndef REFORMANT_PROCESSING_TIMESERIES_H
+#define REFORMANT_PROCESSING_TIMESERIES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+namespace reformant {
+
+// Analysis results sorted by time, stored in chunks of up to chunkLength
+// points. Appending never moves the points that are already stored, and lookups
+// by time are binary searches, so the cost of a range query only depends on the
+// number of points in the range. Old chunks can be dropped from the front:
+// indices are absolute, valid ones are [begin(), size()). Replacing a range
+// only rewrites the chunks that hold it, which may leave them shorter.
+template <typename T>
+class TimeSeries final {
+   public:
+    static constexpr int chunkShift = 12;
+    static constexpr int64_t chunkLength = int64_t(1) << chunkShift;
+
+    TimeSeries() : m_begin(0), m_size(0) {}
+
+    // Times must not decrease.
+    void push_back(const double time, const T& value) {
+        if (m_chunks.empty() || m_chunks.back().times.size() == chunkLength) {
+            m_chunks.emplace_back();
+            m_chunks.back().first = m_size;
+            m_chunks.back().times.reserve(chunkLength);
+            m_chunks.back().values.reserve(chunkLength);
+        }
+        m_chunks.back().times.push_back(time);
+        m_chunks.back().values.push_back(value);
+        ++m_size;
+    }
+
+    // Drop the points from index size on.
+    void truncate(int64_t size) {
+        size = std::max(size, m_begin);
+        if (size >= m_size) return;
+
+        while (!m_chunks.empty() && m_chunks.back().first >= size) m_chunks.pop_back();
+        if (!m_chunks.empty()) {
+            const int64_t tail = size - m_chunks.back().first;
+            m_chunks.back().times.resize(tail);
+            m_chunks.back().values.resize(tail);
+        }
+        m_size = size;
+    }
+
+    // Drop the chunks that only hold points before time t, in O(1) per chunk.
+    // The chunk being appended to is always kept.
+    void dropBefore(const double t) {
+        while (m_chunks.size() > 1 && m_chunks.front().times.back() < t) {
+            m_chunks.pop_front();
+            m_begin = m_chunks.front().first;
+        }
+    }
+
+    // Replace the points with timeMin <= time < timeMax by the given ones,
+    // which must be sorted and lie in the same range. The same number of points
+    // is overwritten in place, otherwise only the chunks holding the range are
+    // rewritten. Returns the change in the number of points.
+    int64_t replaceRange(const double timeMin, const double timeMax,
+                         const std::vector<double>& times, const std::vector<T>& values) {
+        const int64_t first = lowerBound(timeMin);
+        const int64_t last = lowerBound(timeMax);
+        const auto count = static_cast<int64_t>(times.size());
+
+        if (count == last - first) {
+            for (int64_t i = 0; i < count; ++i) {
+                Chunk& chunk = m_chunks[chunkIndex(first + i)];
+                chunk.times[first + i - chunk.first] = times[i];
+                chunk.values[first + i - chunk.first] = values[i];
+            }
+            return 0;
+        }
+
+        if (first == m_size) {
+            for (int64_t i = 0; i < count; ++i) push_back(times[i], values[i]);
+            return count;
+        }
+
+        // An empty range is inserted into the chunk that holds the point after it.
+        const size_t chunkFirst = chunkIndex(first);
+        const size_t chunkLast = (last > first) ? chunkIndex(last - 1) : chunkFirst;
+        const Chunk& head = m_chunks[chunkFirst];
+        const Chunk& tail = m_chunks[chunkLast];
+
+        // What these chunks hold once the range is replaced.
+        const int64_t headLength = first - head.first;
+        const int64_t tailStart = last - tail.first;
+        std::vector<double> newTimes(head.times.begin(), head.times.begin() + headLength);
+        std::vector<T> newValues(head.values.begin(), head.values.begin() + headLength);
+        newTimes.insert(newTimes.end(), times.begin(), times.end());
+        newValues.insert(newValues.end(), values.begin(), values.end());
+        newTimes.insert(newTimes.end(), tail.times.begin() + tailStart, tail.times.end());
+        newValues.insert(newValues.end(), tail.values.begin() + tailStart,
+                         tail.values.end());
+
+        std::vector<Chunk> pieces;
+        const auto newLength = static_cast<int64_t>(newTimes.size());
+        for (int64_t offset = 0; offset < newLength; offset += chunkLength) {
+            const int64_t end = std::min(offset + chunkLength, newLength);
+            Chunk& piece = pieces.emplace_back();
+            piece.first = head.first + offset;
+            piece.times.assign(newTimes.begin() + offset, newTimes.begin() + end);
+            piece.values.assign(newValues.begin() + offset, newValues.begin() + end);
+        }
+
+        m_chunks.erase(m_chunks.begin() + chunkFirst, m_chunks.begin() + chunkLast + 1);
+        m_chunks.insert(m_chunks.begin() + chunkFirst,
+                        std::make_move_iterator(pieces.begin()),
+                        std::make_move_iterator(pieces.end()));
+
+        const int64_t sizeChange = count - (last - first);
+        for (size_t c = chunkFirst + pieces.size(); c < m_chunks.size(); ++c) {
+            m_chunks[c].first += sizeChange;
+        }
+        m_size += sizeChange;
+        return sizeChange;
+    }
+
+    void clear() {
+        m_chunks.clear();
+        m_begin = 0;
+        m_size = 0;
+    }
+
+    // Index of the first point that is still stored.
+    [[nodiscard]] int64_t begin() const { return m_begin; }
+    // One past the index of the last point.
+    [[nodiscard]] int64_t size() const { return m_size; }
+    [[nodiscard]] bool empty() const { return m_size == m_begin; }
+
+    [[nodiscard]] double time(const int64_t index) const {
+        const Chunk& chunk = m_chunks[chunkIndex(index)];
+        return chunk.times[index - chunk.first];
+    }
+
+    [[nodiscard]] const T& value(const int64_t index) const {
+        const Chunk& chunk = m_chunks[chunkIndex(index)];
+        return chunk.values[index - chunk.first];
+    }
+
+    [[nodiscard]] T& value(const int64_t index) {
+        Chunk& chunk = m_chunks[chunkIndex(index)];
+        return chunk.values[index - chunk.first];
+    }
+
+    // Index of the first point at or after t, size() if there is none.
+    [[nodiscard]] int64_t lowerBound(const double t) const {
+        return partition(m_begin, m_size, [t](const double time) { return time < t; });
+    }
+
+    // Index of the first point after t, size() if there is none.
+    [[nodiscard]] int64_t upperBound(const double t) const {
+        return partition(m_begin, m_size, [t](const double time) { return time <= t; });
+    }
+
+    // Same as upperBound(t), searching outwards from a previous result.
+    // Queries that move forward or backward by a few points at a time cost
+    // O(1) each instead of O(log n).
+    [[nodiscard]] int64_t upperBound(const double t, int64_t hint) const {
+        hint = std::clamp<int64_t>(hint, m_begin, m_size);
+
+        int64_t lo, hi;
+        int64_t step = 1;
+
+        if (hint < m_size && time(hint) <= t) {
+            // Gallop forward: time(lo) <= t.
+            lo = hint;
+            while (lo + step < m_size && time(lo + step) <= t) {
+                lo += step;
+                step *= 2;
+            }
+            hi = std::min(lo + step, m_size);
+            return partition(lo + 1, hi, [t](const double time) { return time <= t; });
+        }
+
+        // Gallop backward: hint == size() or time(hi) > t.
+        hi = hint;
+        while (hi - step >= m_begin && time(hi - step) > t) {
+            hi -= step;
+            step *= 2;
+        }
+        lo = std::max<int64_t>(hi - step, m_begin - 1);
+        return partition(lo + 1, hi, [t](const double time) { return time <= t; });
+    }
+
+    // Calls f(time, value) for each point with timeMin <= time <= timeMax.
+    template <typename F>
+    void forEachInRange(const double timeMin, const double timeMax, F&& f) const {
+        const int64_t end = upperBound(timeMax);
+        for (int64_t i = lowerBound(timeMin); i < end;) {
+            const Chunk& chunk = m_chunks[chunkIndex(i)];
+            const int64_t chunkEnd =
+                std::min(end, chunk.first + static_cast<int64_t>(chunk.times.size()));
+            for (; i < chunkEnd; ++i) {
+                f(chunk.times[i - chunk.first], chunk.values[i - chunk.first]);
+            }
+        }
+    }
+
+   private:
+    struct Chunk {
+        // Index of the first point, chunks are never empty.
+        int64_t first;
+        std::vector<double> times;
+        std::vector<T> values;
+    };
+
+    // Chunk holding a stored index. Chunks hold at most chunkLength points, so
+    // it is never before the one it would be in if they were all full, which
+    // it is unless replaceRange() shortened some.
+    [[nodiscard]] size_t chunkIndex(const int64_t index) const {
+        const auto guess = std::min(static_cast<size_t>((index - m_begin) >> chunkShift),
+                                    m_chunks.size() - 1);
+        const auto next = m_chunks.begin() + guess + 1;
+        if (next == m_chunks.end() || next->first > index) return guess;
+
+        const auto after = std::upper_bound(
+            next, m_chunks.end(), index,
+            [](const int64_t i, const Chunk& chunk) { return i < chunk.first; });
+        return static_cast<size_t>(after - m_chunks.begin()) - 1;
+    }
+
+    // First index in [first, last) for which pred(time) is false, assuming
+    // the points for which it is true all come first.
+    template <typename Pred>
+    [[nodiscard]] int64_t partition(int64_t first, int64_t last, Pred pred) const {
+        while (first < last) {
+            const int64_t mid = first + (last - first) / 2;
+            if (pred(time(mid))) {
+                first = mid + 1;
+            } else {
+                last = mid;
+            }
+        }
+        return first;
+    }
+
+    std::deque<Chunk> m_chunks;
+    int64_t m_begin;
+    int64_t m_size;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_TIMESERIES_H
@@ -0,0 +1,53 @@
+#include "timeseriessummary.h"
+
+#include <cmath>
+
+using namespace reformant;
+
+TimeSeriesSummary::TimeSeriesSummary() : m_summarizedCount(0) {}
+
+void TimeSeriesSummary::clear() {
+    for (auto& level : m_levels) level.clear();
+    m_summarizedCount = 0;
+}
+
+void TimeSeriesSummary::dropBefore(const double t) {
+    // Buckets are keyed by their start, a bucket that starts before t may
+    // still hold points after it.
+    for (int level = 0; level < levelCount; ++level) {
+        m_levels[level].dropBefore(t - bucketDuration(level));
+    }
+}
+
+double TimeSeriesSummary::bucketDuration(const int level) {
+    double duration = baseBucketDuration;
+    for (int i = 0; i < level; ++i) duration *= levelFactor;
+    return duration;
+}
+
+double TimeSeriesSummary::bucketStart(const double time, const double duration) {
+    return std::floor(time / duration) * duration;
+}
+
+void TimeSeriesSummary::fold(Level& level, const double duration, const double time,
+                             const double value) {
+    const double start = bucketStart(time, duration);
+
+    if (level.empty() || level.time(level.size() - 1) != start) {
+        level.push_back(start, Extrema{time, value, time, value});
+        return;
+    }
+
+    fold(level.value(level.size() - 1), time, value);
+}
+
+void TimeSeriesSummary::fold(Extrema& e, const double time, const double value) {
+    if (value < e.minValue) {
+        e.minTime = time;
+        e.minValue = value;
+    }
+    if (value > e.maxValue) {
+        e.maxTime = time;
+        e.maxValue = value;
+    }
+}
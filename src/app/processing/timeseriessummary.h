@@ -0,0 +1,228 @@
+#ifndef REFORMANT_PROCESSING_TIMESERIESSUMMARY_H
+#define REFORMANT_PROCESSING_TIMESERIESSUMMARY_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "timeseries.h"
+
+namespace reformant {
+
+// Value of a point of a TimeSeries<double>.
+struct SeriesValue {
+    double operator()(const double value) const { return value; }
+};
+
+// Level-of-detail pyramid over a TimeSeries for plotting.
+// Each level splits time into buckets of 40 ms, 160 ms, 640 ms, 2.56 s and
+// 10.24 s and keeps the lowest and highest point of each bucket. A query picks
+// the coarsest level whose buckets are no wider than a pixel column, so it
+// returns at most a few points per column whatever the zoom.
+// Series of other types are summarized through valueOf, which maps a point to
+// the double that is plotted.
+class TimeSeriesSummary final {
+   public:
+    static constexpr int levelCount = 5;
+    static constexpr double baseBucketDuration = 0.04;
+    static constexpr int levelFactor = 4;
+
+    TimeSeriesSummary();
+
+    // Bring the summary in line with series, where only the points from index
+    // firstChanged on were appended, removed or replaced since the last update.
+    template <typename T, typename ValueOf = SeriesValue>
+    void update(const TimeSeries<T>& series, int64_t firstChanged,
+                ValueOf valueOf = {});
+
+    // Bring the summary in line with series after TimeSeries::replaceRange()
+    // changed the points in [timeMin, timeMax) and their count by sizeChange.
+    // Only the buckets overlapping the range are folded again, provided the
+    // summary was up to date before the change.
+    template <typename T, typename ValueOf = SeriesValue>
+    void updateRange(const TimeSeries<T>& series, double timeMin, double timeMax,
+                     int64_t sizeChange, ValueOf valueOf = {});
+
+    void clear();
+
+    // Drop the buckets before time t, following TimeSeries::dropBefore().
+    void dropBefore(double t);
+
+    [[nodiscard]] static double bucketDuration(int level);
+
+    // Points of series in [timeMin, timeMax], reduced for a plot with the given
+    // time per pixel. Results are appended to times and values in time order.
+    template <typename T, typename ValueOf = SeriesValue>
+    void query(const TimeSeries<T>& series, double timeMin, double timeMax,
+               double timePerPixel, std::vector<double>& times,
+               std::vector<double>& values, ValueOf valueOf = {}) const;
+
+   private:
+    struct Extrema {
+        double minTime;
+        double minValue;
+        double maxTime;
+        double maxValue;
+    };
+
+    // Keyed by the start time of the bucket.
+    using Level = TimeSeries<Extrema>;
+
+    template <typename T, typename ValueOf>
+    void queryLevel(const TimeSeries<T>& series, int level, double timeMin,
+                    double timeMax, std::vector<double>& times,
+                    std::vector<double>& values, ValueOf& valueOf) const;
+
+    [[nodiscard]] static double bucketStart(double time, double duration);
+
+    static void fold(Level& level, double duration, double time, double value);
+
+    static void fold(Extrema& e, double time, double value);
+
+    std::array<Level, levelCount> m_levels;
+    int64_t m_summarizedCount;
+
+    // Buckets folded again by updateRange().
+    std::vector<double> m_bucketTimes;
+    std::vector<Extrema> m_buckets;
+};
+
+template <typename T, typename ValueOf>
+void TimeSeriesSummary::update(const TimeSeries<T>& series, int64_t firstChanged,
+                               ValueOf valueOf) {
+    firstChanged = std::min(firstChanged, m_summarizedCount);
+
+    if (firstChanged <= series.begin()) {
+        clear();
+        m_summarizedCount = series.begin();
+    } else if (firstChanged < m_summarizedCount) {
+        // The bucket holding the last unchanged point may also hold changed
+        // ones, so it is folded again from scratch on every level.
+        const double lastKept = series.time(firstChanged - 1);
+
+        for (int level = 0; level < levelCount; ++level) {
+            const double duration = bucketDuration(level);
+            const double start = bucketStart(lastKept, duration);
+
+            auto& buckets = m_levels[level];
+            buckets.truncate(buckets.lowerBound(start));
+
+            for (int64_t i = series.lowerBound(start); i < firstChanged; ++i) {
+                fold(buckets, duration, series.time(i), valueOf(series.value(i)));
+            }
+        }
+        m_summarizedCount = firstChanged;
+    }
+
+    for (int64_t i = m_summarizedCount; i < series.size(); ++i) {
+        const double value = valueOf(series.value(i));
+        for (int level = 0; level < levelCount; ++level) {
+            fold(m_levels[level], bucketDuration(level), series.time(i), value);
+        }
+    }
+    m_summarizedCount = series.size();
+}
+
+template <typename T, typename ValueOf>
+void TimeSeriesSummary::updateRange(const TimeSeries<T>& series, const double timeMin,
+                                    const double timeMax, const int64_t sizeChange,
+                                    ValueOf valueOf) {
+    if (m_summarizedCount + sizeChange != series.size()) {
+        update(series, series.lowerBound(timeMin), valueOf);
+        return;
+    }
+
+    for (int level = 0; level < levelCount; ++level) {
+        const double duration = bucketDuration(level);
+        const double rangeStart = bucketStart(timeMin, duration);
+        const double rangeEnd = bucketStart(timeMax, duration) + duration;
+
+        // Points are picked by the bucket they fold into, so that rounding in
+        // bucketStart() can't put one on both sides of the range.
+        m_bucketTimes.clear();
+        m_buckets.clear();
+        const auto foldPoint = [&](const double time, const T& point) {
+            const double start = bucketStart(time, duration);
+            if (start < rangeStart || start >= rangeEnd) return;
+
+            const double value = valueOf(point);
+            if (m_bucketTimes.empty() || m_bucketTimes.back() != start) {
+                m_bucketTimes.push_back(start);
+                m_buckets.push_back(Extrema{time, value, time, value});
+            } else {
+                fold(m_buckets.back(), time, value);
+            }
+        };
+        series.forEachInRange(rangeStart - duration, rangeEnd + duration, foldPoint);
+
+        m_levels[level].replaceRange(rangeStart, rangeEnd, m_bucketTimes, m_buckets);
+    }
+    m_summarizedCount = series.size();
+}
+
+template <typename T, typename ValueOf>
+void TimeSeriesSummary::query(const TimeSeries<T>& series, const double timeMin,
+                              const double timeMax, const double timePerPixel,
+                              std::vector<double>& times, std::vector<double>& values,
+                              ValueOf valueOf) const {
+    int level = levelCount - 1;
+    while (level >= 0 && bucketDuration(level) > timePerPixel) --level;
+
+    queryLevel(series, level, timeMin, timeMax, times, values, valueOf);
+}
+
+template <typename T, typename ValueOf>
+void TimeSeriesSummary::queryLevel(const TimeSeries<T>& series, const int level,
+                                   const double timeMin, const double timeMax,
+                                   std::vector<double>& times,
+                                   std::vector<double>& values,
+                                   ValueOf& valueOf) const {
+    // Zoomed in further than the finest buckets: the raw points are sparse
+    // enough already.
+    if (level < 0) {
+        series.forEachInRange(timeMin, timeMax, [&](const double time, const T& value) {
+            times.push_back(time);
+            values.push_back(valueOf(value));
+        });
+        return;
+    }
+
+    const auto emit = [&](const double time, const double value) {
+        times.push_back(time);
+        values.push_back(value);
+    };
+
+    const double duration = bucketDuration(level);
+    const Level& buckets = m_levels[level];
+
+    const int64_t end = buckets.upperBound(timeMax);
+    for (int64_t i = buckets.lowerBound(timeMin - duration); i < end; ++i) {
+        const double bucketStart = buckets.time(i);
+        const double bucketEnd = bucketStart + duration;
+
+        // Buckets cut by the range edges are resolved on a finer level.
+        if (bucketStart < timeMin || bucketEnd > timeMax) {
+            queryLevel(series, level - 1, std::max(timeMin, bucketStart),
+                       std::min(timeMax, std::nextafter(bucketEnd, bucketStart)), times,
+                       values, valueOf);
+            continue;
+        }
+
+        const Extrema& e = buckets.value(i);
+        if (e.minTime == e.maxTime) {
+            emit(e.minTime, e.minValue);
+        } else if (e.minTime < e.maxTime) {
+            emit(e.minTime, e.minValue);
+            emit(e.maxTime, e.maxValue);
+        } else {
+            emit(e.maxTime, e.maxValue);
+            emit(e.minTime, e.minValue);
+        }
+    }
+}
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_TIMESERIESSUMMARY_H
@@ -0,0 +1,8 @@
+#include "fftw.h"
+
+using namespace reformant;
+
+std::mutex& util::fftwPlannerMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
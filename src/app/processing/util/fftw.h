@@ -0,0 +1,16 @@
+#ifndef REFORMANT_PROCESSING_UTIL_FFTW_H
+#define REFORMANT_PROCESSING_UTIL_FFTW_H
+
+#include <mutex>
+
+namespace reformant {
+namespace util {
+
+// The FFTW planner isn't thread-safe: every plan creation and destruction
+// must happen with this mutex held. Executing plans doesn't need it.
+std::mutex& fftwPlannerMutex();
+
+}  // namespace util
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_UTIL_FFTW_H
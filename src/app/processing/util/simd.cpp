@@ -0,0 +1,168 @@
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define REFORMANT_SIMD_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define REFORMANT_SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+// GCC and Clang need the target attribute to emit AVX2 code in a translation
+// unit built for the baseline ISA. MSVC accepts the intrinsics as they are.
+#if defined(REFORMANT_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define REFORMANT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+    #define REFORMANT_TARGET_AVX2
+#endif
+
+using namespace reformant;
+
+namespace {
+using DotFunc = double (*)(const float*, const float*, int);
+
+#if !REFORMANT_SIMD_X86 && !REFORMANT_SIMD_NEON
+double dotScalar(const float* a, const float* b, const int n) {
+    double sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum += double(a[i]) * b[i];
+    }
+    return sum;
+}
+#endif
+
+#if REFORMANT_SIMD_X86
+double horizontalSum(const __m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+double dotSse2(const float* a, const float* b, const int n) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 va = _mm_loadu_ps(a + i);
+        const __m128 vb = _mm_loadu_ps(b + i);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_cvtps_pd(va), _mm_cvtps_pd(vb)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(va, va)),
+                                           _mm_cvtps_pd(_mm_movehl_ps(vb, vb))));
+    }
+
+    double sum = horizontalSum(_mm_add_pd(acc0, acc1));
+    for (; i < n; ++i) sum += double(a[i]) * b[i];
+    return sum;
+}
+
+REFORMANT_TARGET_AVX2
+double dotAvx2(const float* a, const float* b, const int n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256 va0 = _mm256_loadu_ps(a + i);
+        const __m256 vb0 = _mm256_loadu_ps(b + i);
+        const __m256 va1 = _mm256_loadu_ps(a + i + 8);
+        const __m256 vb1 = _mm256_loadu_ps(b + i + 8);
+
+        acc0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(va0)),
+                               _mm256_cvtps_pd(_mm256_castps256_ps128(vb0)), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(va0, 1)),
+                               _mm256_cvtps_pd(_mm256_extractf128_ps(vb0, 1)), acc1);
+        acc2 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(va1)),
+                               _mm256_cvtps_pd(_mm256_castps256_ps128(vb1)), acc2);
+        acc3 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(va1, 1)),
+                               _mm256_cvtps_pd(_mm256_extractf128_ps(vb1, 1)), acc3);
+    }
+    for (; i + 4 <= n; i += 4) {
+        acc0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm_loadu_ps(a + i)),
+                               _mm256_cvtps_pd(_mm_loadu_ps(b + i)), acc0);
+    }
+
+    const __m256d acc = _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    double sum = horizontalSum(
+        _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1)));
+    for (; i < n; ++i) sum += double(a[i]) * b[i];
+    return sum;
+}
+
+bool cpuHasAvx2() {
+    #if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    #elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    const bool hasFma = (info[2] & (1 << 12)) != 0;
+    const bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+    if (!hasFma || !hasOsxsave) return false;
+
+    // The OS must save the YMM registers.
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+    #else
+    return false;
+    #endif
+}
+#endif  // REFORMANT_SIMD_X86
+
+#if REFORMANT_SIMD_NEON
+double dotNeon(const float* a, const float* b, const int n) {
+    float64x2_t acc0 = vdupq_n_f64(0);
+    float64x2_t acc1 = vdupq_n_f64(0);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t va = vld1q_f32(a + i);
+        const float32x4_t vb = vld1q_f32(b + i);
+        acc0 = vfmaq_f64(acc0, vcvt_f64_f32(vget_low_f32(va)),
+                         vcvt_f64_f32(vget_low_f32(vb)));
+        acc1 = vfmaq_f64(acc1, vcvt_high_f64_f32(va), vcvt_high_f64_f32(vb));
+    }
+
+    double sum = vaddvq_f64(vaddq_f64(acc0, acc1));
+    for (; i < n; ++i) sum += double(a[i]) * b[i];
+    return sum;
+}
+#endif  // REFORMANT_SIMD_NEON
+
+struct Kernels {
+    DotFunc dot;
+    const char* name;
+};
+
+Kernels selectKernels() {
+#if REFORMANT_SIMD_X86
+    if (cpuHasAvx2()) return {dotAvx2, "AVX2"};
+    return {dotSse2, "SSE2"};
+#elif REFORMANT_SIMD_NEON
+    return {dotNeon, "NEON"};
+#else
+    return {dotScalar, "scalar"};
+#endif
+}
+
+const Kernels& kernels() {
+    static const Kernels selected = selectKernels();
+    return selected;
+}
+}  // namespace
+
+double util::dotProduct(const float* a, const float* b, const int n) {
+    return kernels().dot(a, b, n);
+}
+
+double util::sumOfSquares(const float* x, const int n) { return kernels().dot(x, x, n); }
+
+const char* util::simdKernelName() { return kernels().name; }
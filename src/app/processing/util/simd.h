@@ -0,0 +1,23 @@
+#ifndef REFORMANT_PROCESSING_UTIL_SIMD_H
+#define REFORMANT_PROCESSING_UTIL_SIMD_H
+
+namespace reformant {
+namespace util {
+
+// Vectorized kernels over float data with double accumulation.
+// The implementation is picked once at runtime: AVX2 or SSE2 on x86, NEON on
+// ARM64, plain C++ otherwise.
+
+// sum(a[i] * b[i]) for 0 <= i < n
+double dotProduct(const float* a, const float* b, int n);
+
+// sum(x[i]^2) for 0 <= i < n
+double sumOfSquares(const float* x, int n);
+
+// Name of the kernel set in use, for diagnostics.
+const char* simdKernelName();
+
+}  // namespace util
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_UTIL_SIMD_H
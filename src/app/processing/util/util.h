@@ -1,6 +1,8 @@
 #ifndef REFORMANT_PROCESSING_UTIL_UTIL_H
 #define REFORMANT_PROCESSING_UTIL_UTIL_H
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace reformant {
@@ -17,6 +19,16 @@ std::vector<T> diff(const std::vector<T>& in) {
     return out;
 }
 
+template <typename T>
+void subtractMean(std::vector<T>& x) {
+    if (x.empty()) return;
+
+    double mu = 0;
+    for (const T& v : x) mu += v;
+    mu /= x.size();
+    for (T& v : x) v -= mu;
+}
+
 template <typename T>
 std::vector<T> product(const std::vector<T>& a, const std::vector<T>& b) {
     std::vector<T> out(a.size());
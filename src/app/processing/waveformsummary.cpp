@@ -0,0 +1,160 @@
+#include "waveformsummary.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace reformant;
+
+static constexpr WaveformStats emptyStats = {
+    std::numeric_limits<float>::max(),
+    std::numeric_limits<float>::lowest(),
+    0,
+};
+
+static void merge(WaveformStats& into, const WaveformStats& other) {
+    into.min = std::min(into.min, other.min);
+    into.max = std::max(into.max, other.max);
+    into.sumOfSquares += other.sumOfSquares;
+}
+
+WaveformSummary::WaveformSummary() { clear(); }
+
+int64_t WaveformSummary::blockLength(const int level) {
+    return int64_t(1) << (baseShift + level * levelShift);
+}
+
+void WaveformSummary::append(const float* samples, int64_t count) {
+    Level& base = m_levels[0];
+    const int64_t length = blockLength(0);
+
+    while (count > 0) {
+        const int64_t n = std::min(count, length - base.pendingLength);
+
+        for (int64_t i = 0; i < n; ++i) {
+            const float x = samples[i];
+            base.pending.min = std::min(base.pending.min, x);
+            base.pending.max = std::max(base.pending.max, x);
+            base.pending.sumOfSquares += x * x;
+        }
+
+        base.pendingLength += n;
+        samples += n;
+        count -= n;
+
+        if (base.pendingLength == length) {
+            pushBlock(0, base.pending);
+            base.pending = emptyStats;
+            base.pendingLength = 0;
+        }
+    }
+}
+
+void WaveformSummary::rebuild(const SampleStore& samples) {
+    clear(samples.begin());
+
+    const int64_t size = samples.size();
+    for (int64_t offset = samples.begin(); offset < size;) {
+        const auto span = samples.contiguous(offset, size - offset);
+        append(span.data(), static_cast<int64_t>(span.size()));
+        offset += static_cast<int64_t>(span.size());
+    }
+}
+
+void WaveformSummary::clear(const int64_t begin) {
+    // The blocks before begin are empty, the one holding it only summarizes
+    // the samples from begin on.
+    for (int i = 0; i < levelCount; ++i) {
+        Level& level = m_levels[i];
+        const int64_t firstBlock = begin / blockLength(i);
+        level.blockCount.store(firstBlock, std::memory_order_release);
+        level.mins.clear(firstBlock);
+        level.maxs.clear(firstBlock);
+        level.sumsOfSquares.clear(firstBlock);
+        level.pending = emptyStats;
+        constexpr int64_t childBlocks = int64_t(1) << levelShift;
+        level.pendingLength = (i == 0) ? begin % blockLength(0)
+                                       : (begin / blockLength(i - 1)) % childBlocks;
+    }
+}
+
+void WaveformSummary::dropBefore(const int64_t index) {
+    for (int i = 0; i < levelCount; ++i) {
+        Level& level = m_levels[i];
+        const int64_t block = index / blockLength(i);
+        level.mins.dropBefore(block);
+        level.maxs.dropBefore(block);
+        level.sumsOfSquares.dropBefore(block);
+    }
+}
+
+WaveformStats WaveformSummary::stats(const SampleStore& samples, const int64_t offset,
+                                     const int64_t length) const {
+    WaveformStats out = emptyStats;
+    accumulate(levelCount - 1, samples, offset, offset + length, out);
+    return out;
+}
+
+void WaveformSummary::pushBlock(const int level, const WaveformStats& block) {
+    Level& l = m_levels[level];
+
+    const float sumOfSquares = static_cast<float>(block.sumOfSquares);
+    l.mins.append(&block.min, 1);
+    l.maxs.append(&block.max, 1);
+    l.sumsOfSquares.append(&sumOfSquares, 1);
+    l.blockCount.store(l.blockCount.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+
+    // Roll the completed block up into the next level.
+    if (level + 1 < levelCount) {
+        Level& next = m_levels[level + 1];
+        merge(next.pending, block);
+        if (++next.pendingLength == (int64_t(1) << levelShift)) {
+            pushBlock(level + 1, next.pending);
+            next.pending = emptyStats;
+            next.pendingLength = 0;
+        }
+    }
+}
+
+void WaveformSummary::accumulate(const int level, const SampleStore& samples,
+                                 const int64_t start, const int64_t end,
+                                 WaveformStats& out) const {
+    if (start >= end) return;
+
+    if (level < 0) {
+        for (int64_t offset = start; offset < end;) {
+            const auto span = samples.contiguous(offset, end - offset);
+            for (const float x : span) {
+                out.min = std::min(out.min, x);
+                out.max = std::max(out.max, x);
+                out.sumOfSquares += x * x;
+            }
+            offset += static_cast<int64_t>(span.size());
+        }
+        return;
+    }
+
+    const Level& l = m_levels[level];
+    const int64_t length = blockLength(level);
+
+    // Only whole blocks that have been published are usable at this level,
+    // the ragged edges are handed down to the finer ones.
+    const int64_t firstBlock = (start + length - 1) / length;
+    const int64_t lastBlock =
+        std::min(end / length, l.blockCount.load(std::memory_order_acquire));
+
+    if (firstBlock >= lastBlock) {
+        accumulate(level - 1, samples, start, end, out);
+        return;
+    }
+
+    accumulate(level - 1, samples, start, firstBlock * length, out);
+
+    for (int64_t block = firstBlock; block < lastBlock; ++block) {
+        out.min = std::min(out.min, l.mins[block]);
+        out.max = std::max(out.max, l.maxs[block]);
+        out.sumOfSquares += l.sumsOfSquares[block];
+    }
+
+    accumulate(level - 1, samples, lastBlock * length, end, out);
+}
@@ -0,0 +1,74 @@
+#ifndef REFORMANT_PROCESSING_WAVEFORMSUMMARY_H
+#define REFORMANT_PROCESSING_WAVEFORMSUMMARY_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "samplestore.h"
+
+namespace reformant {
+
+struct WaveformStats {
+    float min;
+    float max;
+    double sumOfSquares;
+};
+
+// Min/max/sum-of-squares pyramid over a sample store, with blocks of 64,
+// 1024 and 16384 samples. It is updated as samples are appended, so a range
+// query only touches a bounded number of blocks per level plus at most one
+// block's worth of raw samples on each side.
+//
+// Same threading rules as SampleStore: one writer, readers only see the
+// blocks that were published before they started.
+class WaveformSummary final {
+   public:
+    static constexpr int levelCount = 3;
+    static constexpr int baseShift = 6;
+    static constexpr int levelShift = 4;
+
+    WaveformSummary();
+
+    // Feed the samples that were just appended to the summarized store.
+    void append(const float* samples, int64_t count);
+
+    // Drop everything and summarize the whole store again.
+    void rebuild(const SampleStore& samples);
+
+    // Drop everything. The next sample appended has index begin.
+    void clear(int64_t begin = 0);
+
+    // Drop the blocks before sample index, following SampleStore::dropBefore().
+    void dropBefore(int64_t index);
+
+    [[nodiscard]] static int64_t blockLength(int level);
+
+    // Stats over [offset, offset + length) of the summarized store, which must
+    // not start before the first sample that is still stored.
+    [[nodiscard]] WaveformStats stats(const SampleStore& samples, int64_t offset,
+                                      int64_t length) const;
+
+   private:
+    struct Level {
+        SampleStore mins;
+        SampleStore maxs;
+        SampleStore sumsOfSquares;
+        std::atomic<int64_t> blockCount;
+
+        // Block being filled in by the writer.
+        WaveformStats pending;
+        int64_t pendingLength;
+    };
+
+    void pushBlock(int level, const WaveformStats& block);
+
+    void accumulate(int level, const SampleStore& samples, int64_t start,
+                    int64_t end, WaveformStats& out) const;
+
+    std::array<Level, levelCount> m_levels;
+};
+
+}  // namespace reformant
+
+#endif  // REFORMANT_PROCESSING_WAVEFORMSUMMARY_H
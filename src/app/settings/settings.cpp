@@ -12,6 +12,7 @@ static constexpr auto appName = "ReFormant";
 
 static constexpr auto keyShowAudioSettings = "show_audio_settings";
 static constexpr auto keyShowDisplaySettings = "show_display_settings";;
+static constexpr auto keyShowAnalysisSettings = "show_analysis_settings";
 static constexpr auto keyShowProfiler = "show_profiler";
 static constexpr auto keyPlotRatioSpectrogram = "plot_ratio_spectrogram";
 static constexpr auto keyPlotRatioWaveform = "plot_ratio_waveform";
@@ -24,12 +25,19 @@ static constexpr auto keyPitchColor = "pitch_color";
 static constexpr auto keyFormantColor = "formant_color";
 static constexpr auto keyStartRecordingOnLaunch = "auto_record_on_launch";
 static constexpr auto keyEnableNoiseReduction = "enable_noise_reduction";
+static constexpr auto keyTrackOnDisk = "track_on_disk";
+static constexpr auto keyRollingWindowMinutes = "rolling_window_minutes";
 static constexpr auto keyAudioHostApi = "audio_host_api";
 static constexpr auto keyInputDeviceName = "audio_input_device_name";
 static constexpr auto keyOutputDeviceName = "audio_output_device_name";
 static constexpr auto keyTrackSampleRate = "track_sample_rate";
 static constexpr auto keyFftLength = "fft_length";
 static constexpr auto keySpectrogramMemory = "spectrogram_memory";
+static constexpr auto keyPitchEstimator = "pitch_estimator";
+static constexpr auto keyPitchNccfMethod = "pitch_nccf_method";
+static constexpr auto keyPitchHopMs = "pitch_hop_ms";
+static constexpr auto keyPitchTrackingLagMs = "pitch_tracking_lag_ms";
+static constexpr auto keyFormantRootSolver = "formant_root_solver";
 
 static const std::string suffixRed = "_r";
 static const std::string suffixGreen = "_g";
@@ -98,6 +106,15 @@ void Settings::setShowDisplaySettings(bool bFlag) {
     save();
 }
 
+bool Settings::showAnalysisSettings() {
+    return save(mapBoolGet(m_map, keyShowAnalysisSettings, false));
+}
+
+void Settings::setShowAnalysisSettings(bool bFlag) {
+    mapBoolSet(m_map, keyShowAnalysisSettings, bFlag);
+    save();
+}
+
 bool Settings::showProfiler() {
     return save(mapBoolGet(m_map, keyShowProfiler, false));
 }
@@ -207,6 +224,22 @@ void Settings::setNoiseReduction(bool bFlag) {
     if (mapBoolSet(m_map, keyEnableNoiseReduction, bFlag)) save();
 }
 
+bool Settings::diskBackedTrack() {
+    return save(mapBoolGet(m_map, keyTrackOnDisk, false));
+}
+
+void Settings::setDiskBackedTrack(bool bFlag) {
+    if (mapBoolSet(m_map, keyTrackOnDisk, bFlag)) save();
+}
+
+int Settings::rollingWindowMinutes() {
+    return save(mapIntGet(m_map, keyRollingWindowMinutes, 0));
+}
+
+void Settings::setRollingWindowMinutes(int minutes) {
+    if (mapIntSet(m_map, keyRollingWindowMinutes, minutes)) save();
+}
+
 int Settings::audioHostApi() {
     // Don't save default value, it will be set to the correct value if negative
     return mapIntGet(m_map, keyAudioHostApi, -1);
@@ -255,6 +288,43 @@ void Settings::setMaxSpectrogramMemory(uint64_t mem) {
     if (mapU64Set(m_map, keySpectrogramMemory, mem)) save();
 }
 
+int Settings::pitchEstimator() { return save(mapIntGet(m_map, keyPitchEstimator, 0)); }
+
+void Settings::setPitchEstimator(int estimator) {
+    if (mapIntSet(m_map, keyPitchEstimator, estimator)) save();
+}
+
+int Settings::pitchNccfMethod() {
+    // Default to FFT-based correlation.
+    return save(mapIntGet(m_map, keyPitchNccfMethod, 1));
+}
+
+void Settings::setPitchNccfMethod(int method) {
+    if (mapIntSet(m_map, keyPitchNccfMethod, method)) save();
+}
+
+double Settings::pitchHopMs() { return save(mapDoubleGet(m_map, keyPitchHopMs, 10)); }
+
+void Settings::setPitchHopMs(double hopMs) {
+    if (mapDoubleSet(m_map, keyPitchHopMs, hopMs)) save();
+}
+
+double Settings::pitchTrackingLagMs() {
+    return save(mapDoubleGet(m_map, keyPitchTrackingLagMs, 200));
+}
+
+void Settings::setPitchTrackingLagMs(double lagMs) {
+    if (mapDoubleSet(m_map, keyPitchTrackingLagMs, lagMs)) save();
+}
+
+int Settings::formantRootSolver() {
+    return save(mapIntGet(m_map, keyFormantRootSolver, 0));
+}
+
+void Settings::setFormantRootSolver(int solver) {
+    if (mapIntSet(m_map, keyFormantRootSolver, solver)) save();
+}
+
 
 // -- define the default no-op settings backend for default initialization.
 
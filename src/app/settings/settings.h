@@ -40,6 +40,10 @@ public:
 
     void setShowDisplaySettings(bool bFlag);
 
+    bool showAnalysisSettings();
+
+    void setShowAnalysisSettings(bool bFlag);
+
     bool showProfiler();
 
     void setShowProfiler(bool bFlag);
@@ -84,6 +88,15 @@ public:
 
     void setNoiseReduction(bool bFlag);
 
+    bool diskBackedTrack();
+
+    void setDiskBackedTrack(bool bFlag);
+
+    // Only keep the last minutes of the track, zero keeps everything.
+    int rollingWindowMinutes();
+
+    void setRollingWindowMinutes(int minutes);
+
     int audioHostApi();
 
     void setAudioHostApi(int hostApiType);
@@ -108,6 +121,26 @@ public:
 
     void setMaxSpectrogramMemory(uint64_t mem);
 
+    int pitchEstimator();
+
+    void setPitchEstimator(int estimator);
+
+    int pitchNccfMethod();
+
+    void setPitchNccfMethod(int method);
+
+    double pitchHopMs();
+
+    void setPitchHopMs(double hopMs);
+
+    double pitchTrackingLagMs();
+
+    void setPitchTrackingLagMs(double lagMs);
+
+    int formantRootSolver();
+
+    void setFormantRootSolver(int solver);
+
 private:
     // Wrapper to save and return value in one line.
     template <typename T>
@@ -13,6 +13,8 @@
 struct GLFWwindow;
 
 namespace reformant {
+class PlaybackEngine;
+class WorkerPool;
 class PitchController;
 class FormantController;
 class SpectrogramController;
@@ -27,6 +29,7 @@ struct UiState {
     ImFont* faSolid;
     bool showAudioSettings;
     bool showDisplaySettings;
+    bool showAnalysisSettings;
     bool showProfiler;
     // audio settings
     const AudioHostApiInfo* currentAudioHostApi;
@@ -48,6 +51,8 @@ struct UiState {
     double spectrumMaxDb;
     bool isRecording;
     bool isInTimeScrollAnimation;
+    bool isScrubbing;
+    bool resumeAfterScrub;
     // profiler
     double averageProcessingTime;
 };
@@ -58,10 +63,12 @@ struct AppState {
     AudioDevices audioDevices;
     AudioInput audioInput;
     AudioOutput audioOutput;
-    Resampler audioOutputResampler;
+    PlaybackEngine* playbackEngine;
 
     AudioTrack audioTrack;
 
+    WorkerPool* workerPool;
+
     PitchController* pitchController;
     FormantController* formantController;
     SpectrogramController* spectrogramController;
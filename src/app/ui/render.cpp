@@ -4,6 +4,8 @@
 void reformant::ui::render(AppState& appState) {
     // This runs between ImGui::NewFrame() and ImGui::Render()
 
+    ui::applyTrackSampleRate(appState);
+
     ui::dockspace(appState);
 
     if (appState.ui.showAudioSettings) {
@@ -14,6 +16,10 @@ void reformant::ui::render(AppState& appState) {
         ui::displaySettings(appState);
     }
 
+    if (appState.ui.showAnalysisSettings) {
+        ui::analysisSettings(appState);
+    }
+
     if (appState.ui.showProfiler) {
         ui::profiler(appState);
     }
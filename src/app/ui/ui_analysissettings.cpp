@@ -0,0 +1,68 @@
+#include <iterator>
+
+#include "../processing/controller/formantcontroller.h"
+#include "../processing/controller/pitchcontroller.h"
+#include "ui_private.h"
+
+void reformant::ui::analysisSettings(AppState& appState) {
+    if (ImGui::Begin("Analysis settings", &appState.ui.showAnalysisSettings)) {
+        int estimator = appState.pitchController->estimatorType();
+        if (ImGui::Combo("Pitch estimator", &estimator, "NCCF (RAPT)\0YIN\0")) {
+            appState.pitchController->setEstimatorType(
+                static_cast<PitchEstimatorType>(estimator));
+            appState.settings.setPitchEstimator(estimator);
+        }
+
+        int nccfMethod = appState.pitchController->nccfMethod();
+        if (ImGui::Combo("Pitch correlation", &nccfMethod, "Direct\0FFT\0")) {
+            appState.pitchController->setNccfMethod(
+                static_cast<NccfMethod>(nccfMethod));
+            appState.settings.setPitchNccfMethod(nccfMethod);
+        }
+
+        // Zero hops by a whole correlation window.
+        static constexpr double hopChoices[] = {0, 5, 10, 20};
+        const double hopMs = appState.pitchController->hopMs();
+        int hopIndex = 0;
+        for (int i = 0; i < std::size(hopChoices); ++i) {
+            if (hopChoices[i] == hopMs) hopIndex = i;
+        }
+        if (ImGui::Combo("Pitch frame step", &hopIndex,
+                         "Window length\0" "5 ms\0" "10 ms\0" "20 ms\0")) {
+            appState.pitchController->setHopMs(hopChoices[hopIndex]);
+            appState.settings.setPitchHopMs(hopChoices[hopIndex]);
+        }
+
+        static constexpr double lagChoices[] = {100, 200, 300};
+        const double lagMs = appState.pitchController->trackingLagMs();
+        int lagIndex = 1;
+        for (int i = 0; i < std::size(lagChoices); ++i) {
+            if (lagChoices[i] == lagMs) lagIndex = i;
+        }
+        if (ImGui::Combo("Pitch tracking delay", &lagIndex,
+                         "100 ms\0" "200 ms\0" "300 ms\0")) {
+            appState.pitchController->setTrackingLagMs(lagChoices[lagIndex]);
+            appState.settings.setPitchTrackingLagMs(lagChoices[lagIndex]);
+        }
+
+        if (const double micros = appState.pitchController->averageFrameMicros();
+            micros >= 0) {
+            ImGui::Text("Pitch estimation: %.1f us per frame", micros);
+        }
+
+        int rootSolver = appState.formantController->rootSolver();
+        if (ImGui::Combo("Formant root solver", &rootSolver, "Bairstow\0Aberth\0")) {
+            appState.formantController->setRootSolver(
+                static_cast<RootSolver>(rootSolver));
+            appState.settings.setFormantRootSolver(rootSolver);
+        }
+
+        if (const double micros = appState.formantController->averageFrameMicros();
+            micros >= 0) {
+            ImGui::Text("Formant analysis: %.1f us per frame", micros);
+        }
+    }
+    ImGui::End();
+
+    appState.settings.setShowAnalysisSettings(appState.ui.showAnalysisSettings);
+}
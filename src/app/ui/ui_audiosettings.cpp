@@ -99,9 +99,50 @@ void reformant::ui::audioSettings(AppState& appState) {
             appState.settings.setNoiseReduction(enableNoiseReduction);
         }
 
+        bool diskBackedTrack = appState.settings.diskBackedTrack();
+        if (ImGui::Checkbox("Keep recording track on disk", &diskBackedTrack)) {
+            std::lock_guard trackGuard(appState.audioTrack.mutex());
+            appState.audioTrack.setStorage(diskBackedTrack ? SampleStorage_MappedFile
+                                                           : SampleStorage_Memory);
+            appState.settings.setDiskBackedTrack(diskBackedTrack);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(
+                "Store the track in a temporary file, keeping only the most "
+                "recent audio in memory.");
+        }
+
+        // Zero keeps the whole recording.
+        static constexpr int windowChoices[] = {0, 5, 15, 60, 240};
+        const int windowMinutes = appState.settings.rollingWindowMinutes();
+        int windowIndex = 0;
+        for (int i = 0; i < std::size(windowChoices); ++i) {
+            if (windowChoices[i] == windowMinutes) windowIndex = i;
+        }
+        if (ImGui::Combo("Keep recording", &windowIndex,
+                         "Everything\0" "Last 5 minutes\0" "Last 15 minutes\0"
+                         "Last hour\0" "Last 4 hours\0")) {
+            std::lock_guard trackGuard(appState.audioTrack.mutex());
+            appState.audioTrack.setRollingWindow(60.0 * windowChoices[windowIndex]);
+            appState.settings.setRollingWindowMinutes(windowChoices[windowIndex]);
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip(
+                "For live monitoring: older audio and its analysis are dropped, "
+                "so that memory use stays flat.");
+        }
+
+        ImGui::Text("Track samples: %llu MB",
+                    appState.audioTrack.bytesAllocated() / 1024_u64 / 1024_u64);
+
         const int currentSampleRate = static_cast<int>(appState.audioTrack.sampleRate());
 
-        if (ImGui::BeginCombo("Recording track sample rate",
+        // One change at a time, the track keeps its current rate until the
+        // background resample is done.
+        const bool isChangingSampleRate = appState.audioTrack.isChangingSampleRate();
+
+        if (!isChangingSampleRate &&
+            ImGui::BeginCombo("Recording track sample rate",
                               std::to_string(currentSampleRate).c_str())) {
             std::array trackSampleRates(std::to_array({
                 8000,
@@ -119,20 +160,19 @@ void reformant::ui::audioSettings(AppState& appState) {
 
                 if (ImGui::Selectable(name.c_str(), isSelected)) {
                     std::lock_guard trackGuard(appState.audioTrack.mutex());
-                    bool wasPlaying = appState.audioOutput.isPlaying();
-                    double time = appState.spectrogramController->time();
-                    if (wasPlaying) appState.audioOutput.stopPlaying();
-                    appState.audioTrack.setSampleRate(sampleRate);
+                    appState.audioTrack.requestSampleRate(sampleRate);
                     appState.settings.setTrackSampleRate(sampleRate);
-                    appState.spectrogramController->forceClear();
-                    if (wasPlaying) appState.audioOutput.startPlaying();
-                    appState.spectrogramController->setTime(time);
                 }
             }
 
             ImGui::EndCombo();
         }
 
+        if (isChangingSampleRate) {
+            ImGui::Text("Resampling track to %d Hz...",
+                        static_cast<int>(appState.audioTrack.pendingSampleRate()));
+        }
+
         const int currentFftLength =
             (int)appState.spectrogramController->fftLength();
 
@@ -176,4 +216,18 @@ void reformant::ui::audioSettings(AppState& appState) {
     ImGui::End();
 
     appState.settings.setShowAudioSettings(appState.ui.showAudioSettings);
-}
\ No newline at end of file
+}
+
+void reformant::ui::applyTrackSampleRate(AppState& appState) {
+    if (!appState.audioTrack.isSampleRateChangeReady()) return;
+
+    std::lock_guard trackGuard(appState.audioTrack.mutex());
+
+    // Only the latest samples are left to resample, the swap itself is quick.
+    const double time = appState.spectrogramController->time();
+    const bool wasPlaying = appState.audioOutput.isPlaying();
+    if (wasPlaying) appState.audioOutput.stopPlaying();
+    appState.audioTrack.finishSampleRateChange();
+    appState.spectrogramController->setTime(time);
+    if (wasPlaying) appState.audioOutput.startPlaying();
+}
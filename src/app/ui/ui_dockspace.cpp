@@ -33,9 +33,11 @@ void reformant::ui::dockspace(AppState& appState) {
                          ImGuiDockNodeFlags_PassthruCentralNode);
     }
 
-    appState.audioTrack.mutex().lock();
-    const int trackSampleRate = appState.audioTrack.sampleRate();
-    appState.audioTrack.mutex().unlock();
+    int trackSampleRate;
+    {
+        const auto trackLease = appState.audioTrack.lease();
+        trackSampleRate = appState.audioTrack.sampleRate();
+    }
 
     if (ImGui::BeginMenuBar()) {
         if (ImGui::BeginMenu("File")) {
@@ -69,6 +71,8 @@ void reformant::ui::dockspace(AppState& appState) {
             ImGui::MenuItem("Audio settings", nullptr, &appState.ui.showAudioSettings);
             ImGui::MenuItem("Display settings", nullptr,
                             &appState.ui.showDisplaySettings);
+            ImGui::MenuItem("Analysis settings", nullptr,
+                            &appState.ui.showAnalysisSettings);
             ImGui::MenuItem("Profiler", nullptr, &appState.ui.showProfiler);
 
             ImGui::EndMenu();
@@ -99,9 +103,11 @@ void reformant::ui::dockspace(AppState& appState) {
             const auto filePath = ifd::FileDialog::Instance().GetResult().string();
             const size_t formatIndex = ifd::FileDialog::Instance().GetFilterSelection();
 
-            appState.audioTrack.mutex().lock();
-            const auto data = appState.audioTrack.data();
-            appState.audioTrack.mutex().unlock();
+            std::vector<float> data;
+            {
+                const auto trackLease = appState.audioTrack.lease();
+                data = appState.audioTrack.data();
+            }
 
             const auto formats = audiofiles::getCompatibleFormats(trackSampleRate);
             const auto& format = formats[formatIndex];
@@ -10,7 +10,10 @@ namespace ui {
 
 void dockspace(AppState& appState);
 void audioSettings(AppState& appState);
+// Swap in the track resampled in the background, once it is ready.
+void applyTrackSampleRate(AppState& appState);
 void displaySettings(AppState& appState);
+void analysisSettings(AppState& appState);
 void profiler(AppState& appState);
 void spectrogram(AppState& appState);
 
@@ -1,3 +1,4 @@
+#include "../audio/playbackengine.h"
 #include "../memusage.h"
 #include "../processing/thread/processingthread.h"
 #include "ui_private.h"
@@ -35,6 +36,11 @@ void reformant::ui::profiler(AppState& appState) {
         ImGui::Text("Time spent processing: %d ms",
                     static_cast<int>(std::round(appState.ui.averageProcessingTime)));
 
+        ImGui::Text("Recording overruns: %llu (%llu samples dropped)",
+                    appState.audioInput.overrunCount(),
+                    appState.audioInput.droppedSampleCount());
+        ImGui::Text("Playback underruns: %llu", appState.playbackEngine->underrunCount());
+
         ImGui::Text("FPS: %d", static_cast<int>(std::round(ImGui::GetIO().Framerate)));
     }
     ImGui::End();
@@ -2,6 +2,7 @@
 
 #include <cmath>
 
+#include "../audio/playbackengine.h"
 #include "../processing/controller/formantcontroller.h"
 #include "../processing/controller/pitchcontroller.h"
 #include "../processing/controller/spectrogramcontroller.h"
@@ -29,7 +30,7 @@ constexpr std::array implotFreqScales{ImPlotScale_Linear, ImPlotScale_Log10,
 } // namespace
 
 void reformant::ui::spectrogram(AppState& appState) {
-    std::lock_guard trackGuard(appState.audioTrack.mutex());
+    const auto trackLease = appState.audioTrack.lease();
 
     SpectrogramController& spectrogramController = *appState.spectrogramController;
     PitchController& pitchController = *appState.pitchController;
@@ -38,6 +39,26 @@ void reformant::ui::spectrogram(AppState& appState) {
     if (ImGui::Begin("Spectrogram")) {
         bool timeCursorChangedForcefully = false;
 
+        // Follow the playback position published by the output callback.
+        if (appState.audioOutput.isPlaying()) {
+            spectrogramController.setTimeSamples(appState.playbackEngine->position());
+        }
+
+        // Scrubbing while playing pauses the stream until the mouse is released,
+        // then playback restarts from the new position. In between, only the
+        // engine follows the cursor.
+        const auto scrubTo = [&](const double time) {
+            spectrogramController.setTime(time);
+            if (!appState.ui.isScrubbing) {
+                appState.ui.isScrubbing = true;
+                appState.ui.resumeAfterScrub = appState.audioOutput.isPlaying();
+                if (appState.ui.resumeAfterScrub) appState.audioOutput.stopPlaying();
+            }
+            if (appState.ui.resumeAfterScrub) {
+                appState.playbackEngine->seek(spectrogramController.timeSamples());
+            }
+        };
+
         if (!appState.audioOutput.isPlaying()) {
             ImGui::PushFont(appState.ui.faSolid);
             if (ImGui::Button("\uf04b")) {
@@ -107,9 +128,10 @@ void reformant::ui::spectrogram(AppState& appState) {
         const double sampleRate = appState.audioTrack.sampleRate();
 
         double sliderTime = spectrogramController.time();
-        if (ImGui::SliderDouble("##scrub", &sliderTime, 0, appState.audioTrack.duration(),
-                                "%.3f s")) {
-            spectrogramController.setTime(sliderTime);
+        const double startTime = appState.audioTrack.firstSample() / sampleRate;
+        if (ImGui::SliderDouble("##scrub", &sliderTime, startTime,
+                                appState.audioTrack.duration(), "%.3f s")) {
+            scrubTo(sliderTime);
             timeCursorChangedForcefully = true;
         }
 
@@ -189,7 +211,7 @@ void reformant::ui::spectrogram(AppState& appState) {
                 if (ImPlot::DragLineX(838492, &dragTime, {1, 1, 1, 1}, 2,
                                       ImPlotDragToolFlags_None)) {
                     if (dragTime >= 0 && dragTime <= appState.audioTrack.duration()) {
-                        spectrogramController.setTime(dragTime);
+                        scrubTo(dragTime);
                         timeCursorChangedForcefully = true;
                     }
                 }
@@ -285,7 +307,7 @@ void reformant::ui::spectrogram(AppState& appState) {
                 if (ImPlot::DragLineX(838493, &dragTime, {1, 1, 1, 1}, 2,
                                       ImPlotDragToolFlags_Delayed)) {
                     if (dragTime >= 0 && dragTime <= appState.audioTrack.duration()) {
-                        spectrogramController.setTime(dragTime);
+                        scrubTo(dragTime);
                         timeCursorChangedForcefully = true;
                     }
                 }
@@ -326,9 +348,16 @@ void reformant::ui::spectrogram(AppState& appState) {
     }
     ImGui::End();
 
+    // Checked even if the window was closed mid-drag.
+    if (appState.ui.isScrubbing && !ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        appState.ui.isScrubbing = false;
+        if (appState.ui.resumeAfterScrub) appState.audioOutput.startPlaying();
+    }
+
     // Stop playing if playing past the end of recording
     if (appState.audioOutput.isPlaying() &&
-        spectrogramController.timeSamples() >= appState.audioTrack.sampleCount()) {
+        (appState.playbackEngine->isFinished() ||
+         spectrogramController.timeSamples() >= appState.audioTrack.sampleCount())) {
         appState.audioOutput.stopPlaying();
     }
 }
\ No newline at end of file
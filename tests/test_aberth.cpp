@@ -0,0 +1,117 @@
+// aberth() against lbpoly() on a fixed polynomial with known roots, and
+// repeated aberth() runs against each other.
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <vector>
+
+#include "processing/routines/routines.h"
+
+namespace {
+
+constexpr int order = 6;
+
+// Three conjugate pairs inside the unit circle, like the poles of an LPC fit.
+const std::vector<std::complex<double>> expectedRoots{
+    std::polar(0.95, 0.3), std::polar(0.95, -0.3), std::polar(0.85, 1.2),
+    std::polar(0.85, -1.2), std::polar(0.7, 2.5),   std::polar(0.7, -2.5)};
+
+// Coefficients of the monic polynomial with the expected roots, a[k] being the
+// coefficient of z^k.
+std::vector<double> polynomial() {
+    std::vector<std::complex<double>> c{1.};
+    for (const auto& root : expectedRoots) {
+        c.push_back(0.);
+        for (size_t k = c.size() - 1; k > 0; --k) c[k] = c[k - 1] - root * c[k];
+        c[0] = -root * c[0];
+    }
+    std::vector<double> a(order + 1);
+    for (int k = 0; k <= order; ++k) a[k] = c[k].real();
+    return a;
+}
+
+// Same starting points as formant() uses for the first frame.
+void neutralStart(std::vector<double>& rootr, std::vector<double>& rooti) {
+    rootr.resize(order + 1);
+    rooti.resize(order + 1);
+    const double x = M_PI / (order + 1);
+    for (int i = 0; i <= order; ++i) {
+        const double flo = order - i;
+        rootr[i] = 2. * cos((flo + .5) * x);
+        rooti[i] = 2. * sin((flo + .5) * x);
+    }
+}
+
+// Largest distance from a root in (rootr, rooti) to the nearest expected one.
+double maxRootError(const std::vector<double>& rootr, const std::vector<double>& rooti) {
+    double maxError = 0;
+    for (int i = 0; i < order; ++i) {
+        double error = INFINITY;
+        for (const auto& root : expectedRoots) {
+            error = std::min(error, std::abs(std::complex(rootr[i], rooti[i]) - root));
+        }
+        maxError = std::max(maxError, error);
+    }
+    return maxError;
+}
+
+}  // namespace
+
+int main() {
+    int failures = 0;
+    const auto check = [&](const bool condition, const char* what) {
+        if (!condition) {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            ++failures;
+        }
+    };
+
+    const std::vector<double> a = polynomial();
+
+    // lbpoly() deflates its copy of the polynomial as it goes.
+    std::vector<double> deflated = a;
+    LpcContext bairstowContext;
+    std::vector<double> bairstowR, bairstowI;
+    neutralStart(bairstowR, bairstowI);
+    check(lbpoly(bairstowContext, deflated, order, bairstowR, bairstowI),
+          "lbpoly() converges");
+    check(maxRootError(bairstowR, bairstowI) < 1e-6, "lbpoly() finds the roots");
+
+    LpcContext aberthContext;
+    std::vector<double> aberthR, aberthI;
+    neutralStart(aberthR, aberthI);
+    check(aberth(aberthContext, a, order, aberthR, aberthI), "aberth() converges");
+    check(maxRootError(aberthR, aberthI) < 1e-6, "aberth() finds the roots");
+
+    // Same roots as lbpoly(), maybe in another order.
+    for (int i = 0; i < order; ++i) {
+        const std::complex root(aberthR[i], aberthI[i]);
+        double distance = INFINITY;
+        for (int j = 0; j < order; ++j) {
+            const std::complex other(bairstowR[j], bairstowI[j]);
+            distance = std::min(distance, std::abs(root - other));
+        }
+        check(distance < 1e-6, "aberth() agrees with lbpoly()");
+    }
+
+    // Conjugate pairs side by side with exactly opposite imaginary parts, which
+    // is how formant() tells them apart from real roots.
+    for (int i = 0; i < order; i += 2) {
+        check(aberthR[i] == aberthR[i + 1] && aberthI[i] == -aberthI[i + 1],
+              "aberth() stores conjugate pairs like lbpoly()");
+    }
+
+    // Same input, same output: on a fresh context and on a reused one.
+    for (int run = 0; run < 2; ++run) {
+        LpcContext freshContext;
+        LpcContext& context = (run == 0) ? freshContext : aberthContext;
+        std::vector<double> againR, againI;
+        neutralStart(againR, againI);
+        check(aberth(context, a, order, againR, againI), "aberth() converges again");
+        check(againR == aberthR && againI == aberthI, "aberth() is repeatable");
+    }
+
+    return (failures == 0) ? 0 : 1;
+}